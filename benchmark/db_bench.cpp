@@ -4,12 +4,23 @@
 
 #include <benchmark/benchmark.h>
 
+#include <algorithm>
 #include <filesystem>
+#include <random>
 #include <string>
 #include <vector>
 
+#include "Crc32c.h"
 #include "DBImpl.h"
 #include "Logger.h"
+#include "MemTableRep.h"
+#include "Random.h"
+#include "SSTableBuilder.h"
+#include "SSTableReader.h"
+#include "SkipList.h"
+#include "WalHandler.h"
+#include "network/NetworkBuffer.h"
+#include "network/RESPEncoder.h"
 
 namespace fs = std::filesystem;
 
@@ -54,10 +65,13 @@ static void BenchPut(benchmark::State& state) {
       std::this_thread::sleep_for(std::chrono::seconds(2));
       auto s = db.GetStatus();
       printf(
-          "\n[STAT] Mem:%zu | Imm:%zu | L0:%zu | L1:%zu | MinorCount:%lu | "
-          "LastMinor:%lldms\n",
-          s.mem_count, s.imm_count, s.l0_count, s.l1_count,
-          s.minor_compact_count, s.last_minor_duration_ms);
+          "\n[STAT] Mem:%zu(%zuKB) | Imm:%zu(%zuKB, %zu tables) | L0:%zu | "
+          "L1:%zu | MinorCount:%lu | LastMinor:%lldms | Delay:%lums | "
+          "Stop:%lums\n",
+          s.mem_count, s.mem_bytes / 1024, s.imm_count, s.imm_bytes / 1024,
+          s.imm_tables, s.l0_count, s.l1_count, s.minor_compact_count,
+          s.last_minor_duration_ms, s.write_delay_micros / 1000,
+          s.write_stop_micros / 1000);
       fflush(stdout);
     }
   });
@@ -76,10 +90,119 @@ static void BenchPut(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations());
 }
 
-static void BenchGet(benchmark::State& state) {
+// 多个连接并发 SET：写线程排队组提交，N 次小写合并成一次 WAL 写入
+static void BenchConcurrentPut(benchmark::State& state) {
+  static DBImpl* db = nullptr;
+  if (state.thread_index() == 0) {
+    Logger::SetLevel(LogLevel::Off);
+    PrepareDbDir();
+    db = new DBImpl(kBenchDir);
+  }
+
+  const std::string value(128, 'v');
+  const std::string prefix = "t" + std::to_string(state.thread_index()) + "_";
+  int64_t i = 0;
+  for (auto _ : state) {
+    PutValue(*db, prefix + std::to_string(i++), value);
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0) {
+    delete db;
+    db = nullptr;
+  }
+}
+
+// 50 个 key 一组写入：range(0) 为 0 时逐条 Put，为 1 时打成一个 WriteBatch；
+// range(1) 为 1 时每组都要求同步落盘
+static void BenchWriteBatch(benchmark::State& state) {
   Logger::SetLevel(LogLevel::Off);
   PrepareDbDir();
   DBImpl db(kBenchDir);
+  constexpr int kGroup = 50;
+  const bool use_batch = state.range(0) != 0;
+  WriteOptions write_options;
+  write_options.sync = state.range(1) != 0;
+
+  const std::string value(128, 'v');
+  int64_t i = 0;
+  WriteBatch batch;
+  for (auto _ : state) {
+    batch.Clear();
+    for (int k = 0; k < kGroup; ++k) {
+      const std::string key = "key_" + std::to_string(i++);
+      if (use_batch) {
+        batch.Put(key, value);
+      } else {
+        db.Put(key, ValueRecord{ValueType::kValue, value}, write_options);
+      }
+    }
+    if (use_batch) {
+      db.Write(batch, write_options);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kGroup);
+}
+
+// WAL 同步模式对写延迟的影响：range(0) 0 = kNone, 1 = kEveryWrite, 2 = kPeriodic；
+// range(1) 为 1 时打开流水线写
+static void BenchPutWalSync(benchmark::State& state) {
+  Logger::SetLevel(LogLevel::Off);
+  PrepareDbDir();
+  DBOptions options;
+  options.wal_sync_mode = static_cast<WalSyncMode>(state.range(0));
+  options.wal_sync_interval_ms = 100;
+  options.pipelined_write = state.range(1) != 0;
+  DBImpl db(kBenchDir, options);
+
+  const std::string value(128, 'v');
+  int64_t i = 0;
+  for (auto _ : state) {
+    PutValue(db, "key_" + std::to_string(i++), value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// WAL 记录校验和：range(0) 是数据长度，range(1) 为 1 走硬件指令、0 走 slice-by-8
+static void BenchCrc32c(benchmark::State& state) {
+  const std::string data(state.range(0), 'x');
+  const bool hardware = state.range(1) != 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        hardware ? crc32c::Value(data.data(), data.size())
+                 : crc32c::ExtendPortable(0, data.data(), data.size()));
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// 崩溃恢复的 WAL 回放速度：range(0) 是 value 长度，WAL 总共约 64MB
+static void BenchWalReplay(benchmark::State& state) {
+  Logger::SetLevel(LogLevel::Off);
+  PrepareDbDir();
+  const std::string path = std::string(kBenchDir) + "/replay.wal";
+  const std::string value(state.range(0), 'v');
+  const int64_t records = (64 << 20) / state.range(0);
+  {
+    WalHandler wal(path);
+    for (int64_t i = 0; i < records; ++i) {
+      wal.AddLog("key_" + std::to_string(i), value, ValueType::kValue);
+    }
+  }
+
+  for (auto _ : state) {
+    WalHandler wal(path);
+    size_t replayed = 0;
+    wal.LoadLog([&replayed](ValueType, const std::string&,
+                            const std::string& v) { replayed += v.size(); });
+    benchmark::DoNotOptimize(replayed);
+  }
+  state.SetBytesProcessed(state.iterations() * records * state.range(0));
+}
+
+static void RunGetBench(benchmark::State& state, const DBOptions& options) {
+  Logger::SetLevel(LogLevel::Off);
+  PrepareDbDir();
+  DBImpl db(kBenchDir, options);
 
   const size_t preload = 10000;
   const std::string value(128, 'v');
@@ -103,8 +226,182 @@ static void BenchGet(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations());
 }
 
+static void BenchGet(benchmark::State& state) {
+  RunGetBench(state, DBOptions());
+}
+
+// 同样的点查，打开 MemTable 哈希索引
+static void BenchGetHashIndex(benchmark::State& state) {
+  DBOptions options;
+  options.memtable_hash_index = true;
+  RunGetBench(state, options);
+}
+
+// 单个 SST 的点查：Arg(0) 每次从 mmap 读块，Arg(1) 走块缓存。
+// 衡量一次 SST 探测（过滤器 + 索引 + 块内查找）的 CPU 开销
+static void BenchSSTableGet(benchmark::State& state) {
+  Logger::SetLevel(LogLevel::Off);
+  PrepareDbDir();
+  const std::string path = std::string(kBenchDir) + "/1.sst";
+  const int n = 100000;
+  std::vector<std::string> keys;
+  keys.reserve(n);
+  {
+    WritableFile file(path);
+    SSTableBuilder builder(&file);
+    for (int i = 0; i < n; ++i) {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "key_%016d", i);
+      keys.emplace_back(buf);
+      builder.Add(keys.back(), std::string(100, 'v'), ValueType::kValue, i + 1);
+    }
+    builder.Finish();
+  }
+  std::shared_ptr<BlockCache> cache;
+  if (state.range(0) != 0) {
+    cache = std::make_shared<BlockCache>(64 * 1024 * 1024);
+  }
+  std::unique_ptr<SSTableReader> reader(SSTableReader::Open(path, 1, cache));
+
+  std::mt19937 rng(42);
+  std::shuffle(keys.begin(), keys.end(), rng);
+  ValueRecord record;
+  size_t idx = 0;
+  for (auto _ : state) {
+    const bool found = reader->GetRecord(keys[idx++ % keys.size()], &record);
+    benchmark::DoNotOptimize(found);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 大 value 的 GET 响应：查到 value 后编码成 RESP 写进网络缓冲。
+// Arg(0) 先拷进 ValueRecord 再编码，Arg(1) 用 pin 住的视图直接从 mmap 编码
+static void BenchGetLargeValue(benchmark::State& state) {
+  Logger::SetLevel(LogLevel::Off);
+  PrepareDbDir();
+  DBOptions options;
+  options.block_cache_capacity = 0;
+  DBImpl db(kBenchDir, options);
+
+  const size_t n = 64;
+  const std::string value(128 * 1024, 'v');
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < n; ++i) {
+    keys.push_back("large_" + std::to_string(i));
+    PutValue(db, keys.back(), value);
+  }
+  db.FlushMemTable();
+
+  NetworkBuffer buffer(256 * 1024);
+  ValueRecord record;
+  PinnedValue pinned;
+  size_t idx = 0;
+  for (auto _ : state) {
+    const std::string& key = keys[idx++ % n];
+    if (state.range(0) == 0) {
+      db.Get(key, record);
+      RESPEncoder::EncodeBulkString(&buffer, record.value);
+    } else {
+      db.Get(key, &pinned);
+      RESPEncoder::EncodeBulkString(&buffer, pinned.value());
+    }
+    buffer.RetrieveAll();
+  }
+  state.SetBytesProcessed(state.iterations() * value.size());
+}
+
+// 纯内存跳表插入：Arg(0) 顺序 key（命中插入手指），Arg(1) 乱序 key
+static void BenchSkipListInsert(benchmark::State& state) {
+  const bool shuffled = state.range(0) != 0;
+  const int n = 100000;
+  std::vector<std::string> keys;
+  keys.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "key_%016d", i);
+    keys.emplace_back(buf);
+  }
+  if (shuffled) {
+    std::mt19937 gen(42);
+    std::shuffle(keys.begin(), keys.end(), gen);
+  }
+
+  for (auto _ : state) {
+    SkipList<std::string_view, int> list(16);
+    for (int i = 0; i < n; ++i) {
+      list.insert_element(keys[i], i);
+    }
+    benchmark::DoNotOptimize(list.size());
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+// 跳表抽层高：Arg(0) 旧做法 mt19937 + 浮点分布逐层抛硬币，Arg(1) xorshift + ctz
+static void BenchRandomLevel(benchmark::State& state) {
+  constexpr int kMaxLevel = 16;
+  int64_t sum = 0;
+  if (state.range(0) == 0) {
+    thread_local std::mt19937 gen(std::random_device{}());
+    thread_local std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+    for (auto _ : state) {
+      int level = 1;
+      while (dis(gen) < 0.5f && level < kMaxLevel) {
+        level++;
+      }
+      sum += level;
+    }
+  } else {
+    for (auto _ : state) {
+      sum += Random::ThreadLocal().NextHeight(kMaxLevel);
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// MemTable 底层结构：乱序写入 10 万条后再完整有序遍历一次（模拟落盘）。
+// Arg(0) 跳表，Arg(1) vector 排序
+static void BenchMemTableRepLoad(benchmark::State& state) {
+  const auto type = state.range(0) == 0 ? MemTableRepType::kSkipList
+                                        : MemTableRepType::kVector;
+  const int n = 100000;
+  std::vector<std::string> keys;
+  keys.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    keys.push_back("key_" + std::to_string(i));
+  }
+  std::mt19937 gen(42);
+  std::shuffle(keys.begin(), keys.end(), gen);
+
+  for (auto _ : state) {
+    Arena arena;
+    auto rep = MemTableRep::Create(
+        type, &arena, [](const char*, const char*) { return true; }, 16, 0);
+    for (const auto& key : keys) {
+      rep->Insert(key, key.data());
+    }
+    size_t rows = 0;
+    for (auto it = rep->NewIterator(); it->Valid(); it->Next()) {
+      ++rows;
+    }
+    benchmark::DoNotOptimize(rows);
+  }
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
 BENCHMARK(BenchPut);
+BENCHMARK(BenchConcurrentPut)->Threads(1)->Threads(8)->UseRealTime();
+BENCHMARK(BenchPutWalSync)->ArgsProduct({{0, 1, 2}, {0, 1}})->UseRealTime();
+BENCHMARK(BenchWriteBatch)->ArgsProduct({{0, 1}, {0, 1}})->UseRealTime();
+BENCHMARK(BenchCrc32c)->ArgsProduct({{4096, 65536}, {0, 1}});
+BENCHMARK(BenchWalReplay)->Arg(128)->Arg(4096)->Unit(benchmark::kMillisecond);
 BENCHMARK(BenchGet);
+BENCHMARK(BenchGetHashIndex);
+BENCHMARK(BenchSSTableGet)->Arg(0)->Arg(1);
+BENCHMARK(BenchGetLargeValue)->Arg(0)->Arg(1);
+BENCHMARK(BenchSkipListInsert)->Arg(0)->Arg(1);
+BENCHMARK(BenchRandomLevel)->Arg(0)->Arg(1);
+BENCHMARK(BenchMemTableRepLoad)->Arg(0)->Arg(1);
 
 int main(int argc, char** argv) {
   Logger::SetLevel(LogLevel::Off);
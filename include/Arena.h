@@ -0,0 +1,51 @@
+//
+// Created by 26708 on 2026/3/13.
+//
+// MemTable 专用的内存池：只分配、不单独释放，随 MemTable 析构整体归还。
+// 分配是线程安全的，多个写线程可以同时往同一个 MemTable 里插入。
+
+#ifndef NOVAKV_ARENA_H
+#define NOVAKV_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+class Arena {
+ public:
+  Arena();
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // 返回一段 bytes 长的内存，不保证对齐（用来放 key/value 字节）
+  char* Allocate(size_t bytes);
+
+  // 返回按指针大小对齐的内存（用来放 SkipList 节点）
+  char* AllocateAligned(size_t bytes);
+
+  // 当前 Arena 持有的总字节数（含块内尚未用完的尾部）
+  size_t MemoryUsage() const {
+    return memory_usage_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  char* AllocateFallback(size_t bytes);
+  char* AllocateNewBlock(size_t block_bytes);
+
+  // 保护下面的游标和块列表；临界区只有几次指针加减，竞争很短
+  std::mutex mu_;
+
+  // 当前块的分配游标与剩余字节
+  char* alloc_ptr_;
+  size_t alloc_bytes_remaining_;
+
+  // 所有申请过的块，析构时统一 delete[]
+  std::vector<char*> blocks_;
+
+  std::atomic<size_t> memory_usage_;
+};
+
+#endif  // NOVAKV_ARENA_H
@@ -0,0 +1,93 @@
+//
+// Created by 26708 on 2026/3/26.
+//
+// 读路径上的数据块：不预先解析，查找时先在重启点数组上二分，再从选中的
+// 重启点往后最多扫一个间隔的记录。重启点上的 key 是完整的，二分时直接
+// 指向块数据；前缀压缩的 key 在迭代器自己的缓冲里拼出来，缓冲只增不减。
+// 放进块缓存的块自己持有一份数据拷贝，不再依赖 mmap 和页缓存；
+// 直接指向 mmap 的块不能比 SSTableReader 活得久。
+
+#ifndef NOVAKV_BLOCK_H
+#define NOVAKV_BLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "Storage.h"
+#include "ValueRecord.h"
+
+class Block {
+ public:
+  // 块里的一条记录，value 指向块数据；key 指向块数据或迭代器的缓冲，
+  // 迭代器移动后失效
+  struct Entry {
+    std::string_view key;
+    SequenceNumber sequence = 0;
+    ValueType type = ValueType::kValue;
+    std::string_view value;
+  };
+
+  // 按 (key 升序, sequence 降序) 遍历块里的记录，遇到不完整的记录就停下。
+  // 只在定位之前拷贝或赋值，之后 entry().key 可能指向自己的缓冲
+  class Iter {
+   public:
+    explicit Iter(const Block* block) : block_(block) {}
+
+    bool Valid() const { return valid_; }
+    void SeekToFirst();
+    // 定位到第一条 key >= target 的记录
+    void Seek(std::string_view target);
+    void Next();
+
+    const Entry& entry() const { return entry_; }
+
+   private:
+    // 解析 offset 处的一条记录，成功时停在它上面
+    void ParseAt(uint64_t offset);
+    // 只取重启点上那条记录的用户 key，不动迭代器的状态
+    bool RestartKey(uint32_t index, std::string_view* key) const;
+
+    const Block* block_;
+    uint64_t next_ = 0;  // 下一条记录的偏移
+    // 当前记录的完整 key（含序号后缀），前缀压缩时要靠它拼出下一条
+    std::string_view internal_key_;
+    std::string key_buf_;
+    Entry entry_;
+    bool valid_ = false;
+  };
+
+  // 指向 [data, data + size)，不拷贝。sequenced 时每个 key 的最后 8 字节
+  // 是序号；kPlain 格式的旧块没有重启点数组，只能从头扫
+  Block(const char* data, size_t size, bool sequenced, BlockFormat format);
+
+  Block(const Block&) = delete;
+  Block& operator=(const Block&) = delete;
+
+  // 拷贝一份数据，放进块缓存用
+  static std::shared_ptr<const Block> Copy(const char* data, size_t size,
+                                           bool sequenced,
+                                           BlockFormat format);
+
+  // 放进缓存时占用的字节数
+  size_t Charge() const { return sizeof(Block) + owned_.capacity(); }
+
+ private:
+  Block() = default;
+  void Init(const char* data, size_t size, bool sequenced,
+            BlockFormat format);
+  uint32_t RestartPoint(uint32_t index) const;
+
+  std::string owned_;
+  const char* data_ = nullptr;
+  // 记录部分的长度，不含重启点数组
+  size_t size_ = 0;
+  const char* restarts_ = nullptr;
+  uint32_t num_restarts_ = 0;
+  bool sequenced_ = false;
+  BlockFormat format_ = BlockFormat::kPlain;
+};
+
+#endif  // NOVAKV_BLOCK_H
@@ -7,23 +7,31 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "ValueRecord.h"
 
 class BlockBuilder {
  public:
-  BlockBuilder() = default;
+  // 默认每 16 条记录放一个重启点
+  inline static const int kDefaultRestartInterval = 16;
+
+  explicit BlockBuilder(int restart_interval = kDefaultRestartInterval);
 
   /**
-   * @brief 添加一个键值对到缓冲区
-   * 布局：[KeyLen (4B)] [Key 内容] [ValueType(1B)] [ValueLen (4B)] [Value 内容]
+   * @brief 添加一个键值对到缓冲区，key 必须升序
+   * 布局：[Shared (varint)] [NonShared (varint)] [ValueLen (varint)]
+   *       [ValueType(1B)] [Key 去掉和上一条共享前缀后的部分] [Value 内容]
+   * 重启点上的记录 Shared 为 0，存完整的 key
    */
-  void Add(const std::string& key, const std::string& value, ValueType type);
+  void Add(std::string_view key, std::string_view value, ValueType type);
 
   /**
    * @brief 完成当前块的构建
-   * 在这一版中，我们直接返回 buffer。
-   * 未来如果需要对齐 LevelDB，我们要在这里追加“重启点”信息。
+   * 记录之后追加重启点数组：[Restart0 (4B)] ... [RestartN-1 (4B)] [N (4B)]，
+   * 每个重启点是一条记录在块内的偏移。读的时候先在重启点上二分，
+   * 再从选中的重启点往后最多扫 restart_interval 条
    */
   std::string Finish();
 
@@ -33,7 +41,7 @@ class BlockBuilder {
   void Reset();
 
   /**
-   * @brief 估算当前缓冲区占用的字节数
+   * @brief 估算当前块 Finish 之后的字节数（含重启点数组），空块为 0
    * 用于判断是否达到了 4KB 的阈值，从而触发 Flush 落盘
    */
   size_t CurrentSizeEstimate() const;
@@ -41,9 +49,12 @@ class BlockBuilder {
   bool Empty() const;
 
  private:
-  std::string buffer_;     // 实际存储二进制数据的容器
-  int counter_ = 0;        // 记录存了多少条记录
-  bool finished_ = false;  // 状态标记
+  std::string buffer_;              // 实际存储二进制数据的容器
+  const int restart_interval_;      // 每隔多少条记录放一个重启点
+  std::vector<uint32_t> restarts_;  // 重启点在块内的偏移
+  std::string last_key_;            // 上一条记录的完整 key，用来算共享前缀
+  int counter_ = 0;                 // 记录存了多少条记录
+  bool finished_ = false;           // 状态标记
 };
 
 #endif  // NOVAKV_BLOCK_BUILDER_H
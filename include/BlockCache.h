@@ -0,0 +1,82 @@
+//
+// Created by 26708 on 2026/3/26.
+//
+// 由 DB 持有的数据块缓存：按 (SST 文件号, 块偏移) 缓存解析好的 Block，
+// 按字节数限制总内存，满了按 LRU 淘汰。分成多个分片各自加锁，
+// 并发的点查落在不同分片上时互不阻塞。
+// 取出的块是 shared_ptr，被淘汰时正在用它的读者不受影响。
+
+#ifndef NOVAKV_BLOCKCACHE_H
+#define NOVAKV_BLOCKCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "Block.h"
+
+class BlockCache {
+ public:
+  // capacity 是所有分片加起来的字节数
+  explicit BlockCache(size_t capacity);
+
+  BlockCache(const BlockCache&) = delete;
+  BlockCache& operator=(const BlockCache&) = delete;
+
+  // 命中时把这一块挪到 LRU 的最新端；未命中返回 nullptr
+  std::shared_ptr<const Block> Lookup(uint64_t file_number, uint64_t offset);
+  // 同一个位置已经有块时替换掉。单块比分片容量还大时不缓存
+  void Insert(uint64_t file_number, uint64_t offset,
+              std::shared_ptr<const Block> block);
+  // SST 被删除时调用，把它的块尽早让出来
+  void Erase(uint64_t file_number, uint64_t offset);
+
+  size_t Capacity() const { return capacity_; }
+  // 当前缓存的块一共占用的字节数
+  size_t Usage() const;
+  uint64_t Hits() const;
+  uint64_t Misses() const;
+
+ private:
+  struct Key {
+    uint64_t file_number;
+    uint64_t offset;
+    bool operator==(const Key& other) const {
+      return file_number == other.file_number && offset == other.offset;
+    }
+  };
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  struct Shard {
+    struct Item {
+      Key key;
+      std::shared_ptr<const Block> block;
+      size_t charge;
+    };
+
+    // 调用方持有 mu：从最旧的一端淘汰，直到 usage 不超过 capacity
+    void EvictLocked();
+
+    mutable std::mutex mu;
+    // 队头最新、队尾最旧
+    std::list<Item> lru;
+    std::unordered_map<Key, std::list<Item>::iterator, KeyHash> index;
+    size_t capacity = 0;
+    size_t usage = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+
+  Shard& ShardFor(const Key& key) const;
+
+  const size_t capacity_;
+  const int shard_bits_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+#endif  // NOVAKV_BLOCKCACHE_H
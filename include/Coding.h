@@ -0,0 +1,53 @@
+//
+// Created by 26708 on 2026/3/27.
+//
+// 变长整数编码：每个字节低 7 位存数据，最高位表示后面还有没有字节。
+// 块里的长度字段大多不到 128，用 1 个字节就够，比定长 4 字节省 3 个。
+
+#ifndef NOVAKV_CODING_H
+#define NOVAKV_CODING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// uint32 编码后最多 5 个字节
+inline constexpr size_t kMaxVarint32Length = 5;
+
+inline size_t VarintLength(uint32_t value) {
+  size_t len = 1;
+  while (value >= 128) {
+    value >>= 7;
+    ++len;
+  }
+  return len;
+}
+
+inline void PutVarint32(std::string* dst, uint32_t value) {
+  char buf[kMaxVarint32Length];
+  size_t len = 0;
+  while (value >= 128) {
+    buf[len++] = static_cast<char>(value | 128);
+    value >>= 7;
+  }
+  buf[len++] = static_cast<char>(value);
+  dst->append(buf, len);
+}
+
+// 从 [p, limit) 解出一个 varint32，返回它后面的位置；
+// 数据不完整或超过 5 个字节时返回 nullptr
+inline const char* GetVarint32Ptr(const char* p, const char* limit,
+                                  uint32_t* value) {
+  uint32_t result = 0;
+  for (uint32_t shift = 0; shift <= 28 && p < limit; shift += 7) {
+    const auto byte = static_cast<uint8_t>(*p++);
+    result |= static_cast<uint32_t>(byte & 127) << shift;
+    if ((byte & 128) == 0) {
+      *value = result;
+      return p;
+    }
+  }
+  return nullptr;
+}
+
+#endif  // NOVAKV_CODING_H
@@ -6,18 +6,21 @@
 #define NOVAKV_COMPACTIONENGINE_H
 
 #include <cstddef>
-#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "ManifestManager.h"
 #include "MemTable.h"
 #include "SSTableReader.h"
+#include "TableCache.h"
 
 class CompactionEngine {
  public:
+  // 读 SST 都经由 table_cache，新写的 SST 也放进去
   CompactionEngine(std::string db_path, ManifestManager& manifest_manager,
-                   std::vector<std::vector<SSTableReader*> >& levels);
+                   std::vector<std::vector<FileMetaData> >& levels,
+                   TableCache& table_cache);
 
   // 把完整的MinorCompaction拆分成三阶段分别加锁
   // 这样可以保证最耗时的写SST不在锁中
@@ -28,6 +31,8 @@ class CompactionEngine {
     std::string old_wal_path;
     uint64_t new_sst_id = 0;
     std::string new_sst_path;
+    // 切换时还活着的快照序号（升序），决定哪些旧版本要一起落盘
+    std::vector<SequenceNumber> snapshots;
   };
 
   bool PrepareMinor(MemTable*& mem, MemTable*& imm, uint64_t& active_wal_id,
@@ -37,9 +42,17 @@ class CompactionEngine {
                     const MinorCtx& ctx, SSTableReader* reader,
                     bool& need_l0_compact) const;  // 短操作
 
+  // 一个要写进新 SST 的版本，record.sequence 是它的序号
+  struct VersionedRecord {
+    std::string key;
+    ValueRecord record;
+  };
+
   struct L0ToL1Ctx {
-    std::map<std::string, ValueRecord> merged_l0_records;
-    std::map<std::string, ValueRecord> output_records;
+    // L0 里读到的版本总数
+    size_t input_records = 0;
+    // 按 (key 升序, sequence 降序) 排列
+    std::vector<VersionedRecord> output_records;
     std::vector<uint64_t> l0_input_ids;
     size_t expected_l0_reader_count = 0;
     uint64_t new_sst_id = 0;
@@ -47,16 +60,20 @@ class CompactionEngine {
     bool has_output = false;
   };
 
-  bool PrepareL0ToL1(L0ToL1Ctx& ctx) const;  // 短操作
+  // snapshots 是当前还活着的快照序号（升序）
+  bool PrepareL0ToL1(const std::vector<SequenceNumber>& snapshots,
+                     L0ToL1Ctx& ctx) const;  // 短操作
   SSTableReader* BuildL0ToL1SST(const L0ToL1Ctx& ctx) const;  // 长 IO
   bool InstallL0ToL1(const L0ToL1Ctx& ctx, SSTableReader* reader) const;
 
  private:
+  // L1 里 key 的最新版本是不是一个值；有文件打不开时保守地返回 true
   bool HasVisibleValueInL1(const std::string& key) const;
 
   std::string db_path_;
   ManifestManager& manifest_manager_;
-  std::vector<std::vector<SSTableReader*> >& levels_;
+  std::vector<std::vector<FileMetaData> >& levels_;
+  TableCache& table_cache_;
 };
 
 #endif  // NOVAKV_COMPACTIONENGINE_H
@@ -0,0 +1,31 @@
+//
+// Created by 26708 on 2026/3/21.
+//
+// CRC32C（Castagnoli 多项式）。x86-64 上运行时检测 SSE4.2，有则用 crc32
+// 指令每次处理 8 字节；没有则退回 slice-by-8 查表，每次同样处理 8 字节。
+
+#ifndef NOVAKV_CRC32C_H
+#define NOVAKV_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace crc32c {
+
+// 在已有的 crc（某段数据的 CRC32C）后面接着算 data[0, n)，
+// 结果等于对两段数据拼接起来直接算 Value
+uint32_t Extend(uint32_t crc, const char* data, size_t n);
+
+// 纯软件的 slice-by-8 实现，测试时用来和硬件路径对拍
+uint32_t ExtendPortable(uint32_t crc, const char* data, size_t n);
+
+// 当前 CPU 是否走硬件指令
+bool IsHardwareAccelerated();
+
+inline uint32_t Value(const char* data, const size_t n) {
+  return Extend(0, data, n);
+}
+
+}  // namespace crc32c
+
+#endif  // NOVAKV_CRC32C_H
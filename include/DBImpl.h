@@ -7,7 +7,10 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <set>
 #include <shared_mutex>
 #include <string>
 #include <thread>
@@ -17,70 +20,173 @@
 #include "DBIterator.h"
 #include "ManifestManager.h"
 #include "MemTable.h"
+#include "Options.h"
+#include "PinnedValue.h"
 #include "RecoveryLoader.h"
 #include "SSTableReader.h"
+#include "Snapshot.h"
+#include "TableCache.h"
+#include "WriteBatch.h"
+#include "WriteController.h"
 
 struct DBStatus {
   size_t mem_count;                  // 活跃内存条数
   size_t imm_count;                  // 待落盘内存条数
+  size_t imm_tables;                 // 待落盘 MemTable 张数
+  size_t mem_bytes;                  // 活跃内存占用字节数
+  size_t imm_bytes;                  // 待落盘内存占用字节数
   size_t l0_count;                   // L0 文件数
   size_t l1_count;                   // L1 文件数
   uint64_t minor_compact_count;      // Minor Compaction 触发总次数
   long long last_minor_duration_ms;  // 最近一次 Minor Compaction 耗时 (ms)
+  WriteStallCondition write_stall;   // 当前的写入限速状态
+  uint64_t delayed_write_rate;       // 当前限速速率 (B/s)，不限速时为 0
+  uint64_t write_delay_micros;       // 写线程因限速累计等待的时间 (us)
+  uint64_t write_stop_micros;        // 写线程因停写、imm 排满累计等待的时间 (us)
+  uint64_t block_cache_hits;         // 块缓存命中次数
+  uint64_t block_cache_misses;       // 块缓存未命中次数
+  size_t block_cache_usage;          // 块缓存当前占用字节数
+  size_t open_tables;                // TableCache 里打开着的 SST 个数
+  uint64_t read_errors;              // 读路径上 SST 打不开的次数
+  uint64_t wal_syncs;                // 当前 WAL 的 fdatasync 次数
+  size_t wal_unsynced_bytes;         // 当前 WAL 已写入但还没同步的字节数
+  bool wal_failed;                   // 当前 WAL 写入或同步失败过，DB 拒绝写入
 };
 
 class DBImpl {
  public:
-  explicit DBImpl(std::string db_path);
+  explicit DBImpl(std::string db_path, DBOptions options = DBOptions());
   ~DBImpl();
 
-  void Put(const std::string& key, const ValueRecord& value);
-  bool Get(const std::string& key, ValueRecord& value) const;
+  // WAL 写入或要求的同步失败时返回 false，这次写入读者看不到。WAL 失败后
+  // 之后的写入一律失败，重新打开 DB 时回放 WAL 恢复已确认的写入
+  bool Put(const std::string& key, const ValueRecord& value,
+           const WriteOptions& write_options = WriteOptions());
+  // 原子写入一批 Put/Delete：只写一条 WAL 记录，读者要么看到整批、要么一条也看不到
+  bool Write(const WriteBatch& batch,
+             const WriteOptions& write_options = WriteOptions());
+  // read_options.snapshot 非空时读快照那一刻的值；value.sequence 是读到的
+  // 版本的写入序号，旧格式数据为 0。要查的 SST 打不开时返回 false 并计入
+  // read_errors，不会跳过它去更旧的文件里找
+  bool Get(const std::string& key, ValueRecord& value,
+           const ReadOptions& read_options = ReadOptions()) const;
+  // 零拷贝版 Get：value 指向 MemTable 或 SST 里的数据并 pin 住它，
+  // 大 value 可以直接编码进网络缓冲，不用先拷出来
+  bool Get(const std::string& key, PinnedValue* value,
+           const ReadOptions& read_options = ReadOptions()) const;
   void CompactL0ToL1();
   size_t LevelSize(size_t level) const;
 
   // 迭代器
   std::unique_ptr<DBIterator> NewIterator();
+  // 迭代器初始就停在 start_key 处
+  std::unique_ptr<DBIterator> NewIterator(const std::string& start_key);
+  // 按快照遍历；没给快照时固定在创建这一刻，之后的写入都看不到。
+  // 有 SST 打不开时返回 nullptr：少了一个文件的归并结果可能是旧值
+  std::unique_ptr<DBIterator> NewIterator(const ReadOptions& read_options,
+                                          const std::string& start_key);
+
+  // 记下当前的序号作为快照，不拷贝任何数据。快照存活期间 Compaction
+  // 会保留它能看到的旧版本，用完必须 ReleaseSnapshot
+  const Snapshot* GetSnapshot();
+  void ReleaseSnapshot(const Snapshot* snapshot);
 
   // 显式等待所有后台任务完成
   void Sync();
 
+  // 不等写满，立刻把当前 MemTable 切换出去并等待落盘完成
+  void FlushMemTable();
+
   // 获取当前状态
   DBStatus GetStatus() const;
 
  private:
   void MinorCompaction();
+  // L0 文件数达到 level0_compaction_trigger（或者停写线）时做一次 L0->L1
+  void MaybeCompactL0();
+  // 写入前按限速状态等待，停写时一直等到后台把积压降下去。不能持有 state_mu_
+  void DelayWrite(size_t bytes);
+  // 按当前的 L0 文件数、待落盘和待合并字节数重新设置限速状态。
+  // 调用方需持有 state_mu_ 独占锁
+  void UpdateWriteStall();
+  // 当前 MemTable 写满（或 force）时切换到新的 MemTable，必要时等待后台落盘
+  void MakeRoomForWrite(bool force);
+  // 按 options_ 创建一个新的 MemTable，WAL 编号为 wal_id，序号接着
+  // last_sequence 往下编；有待复用的旧 WAL 时改名拿来用。
+  // 调用方需持有 state_mu_ 独占锁
+  std::shared_ptr<MemTable> NewMemTable(uint64_t wal_id,
+                                        SequenceNumber last_sequence);
+  // 还活着的快照序号，升序、可能重复，交给 Compaction 决定保留哪些版本
+  std::vector<SequenceNumber> LiveSnapshots() const;
+  // 落盘后的旧 WAL：留作复用或者直接删除。调用方需持有 state_mu_ 独占锁
+  void RetireWal(uint64_t wal_id);
+  // 启动时收集上次留下的待复用 WAL，超出上限的删掉
+  void LoadRecycledWals();
+  // 把 mem_ 推入 imms_ 队尾并换上新的 MemTable/WAL，调用方需持有 state_mu_
+  // 独占锁
+  void SwitchMemTable();
+  // 两个 Get 的共同实现，sequence 非空时填入读到的版本的序号
+  bool GetPinned(const std::string& key, const ReadOptions& read_options,
+                 PinnedValue* value, SequenceNumber* sequence) const;
   // 后台进程
   void BackgroundLoop();
+  // kPeriodic 模式下定时同步活跃 WAL 的线程
+  void WalSyncLoop();
 
   std::string db_path_;
+  const DBOptions options_;
   ManifestManager manifest_manager_;
 
-  // 磁盘层：已打开的 SST 列表
-  // levels_[0] 是 L0，levels_[1] 是 L1
-  std::vector<std::vector<SSTableReader*>> levels_;
+  // 所有 SST 共用的数据块缓存，block_cache_capacity 为 0 时为空
+  std::shared_ptr<BlockCache> block_cache_;
+
+  // 按需打开 SST，最多同时打开 max_open_files 个。自带锁，
+  // const 的读路径也要经由它打开文件、调整 LRU
+  mutable TableCache table_cache_;
+
+  // 磁盘层：各层登记的 SST，读的时候经由 table_cache_ 打开。
+  // levels_[0] 是 L0，levels_[1] 是 L1。迭代器持有 reader 的引用，
+  // Compaction 摘掉的文件等迭代器放开后才真正关闭
+  std::vector<std::vector<FileMetaData>> levels_;
 
   CompactionEngine compaction_engine_;
   RecoveryLoader recovery_loader_;
 
-  // 内存层：解耦后的指针
-  MemTable* mem_ = nullptr;
-  MemTable* imm_ = nullptr;
+  // 一张待落盘的只读 MemTable，以及它对应的 WAL ID
+  struct ImmutableMemTable {
+    std::shared_ptr<MemTable> table;
+    uint64_t wal_id;
+  };
+
+  // 内存层：解耦后的指针，迭代器同样持有引用
+  std::shared_ptr<MemTable> mem_;
+  // 队尾最新、队头最旧；读从队尾往前查，后台从队头开始按顺序落盘
+  std::deque<ImmutableMemTable> imms_;
 
   // 维护active_wal_id_
   uint64_t active_wal_id_ = 0;
-  // imm_对应的WAL ID
-  uint64_t imm_wal_id_ = 0;
+
+  // 等待复用的旧 WAL 编号，文件名为 <id>.recycle，回放时不会被当成 WAL
+  std::deque<uint64_t> recycled_wals_;
 
   // 可观测性指标
   std::atomic<uint64_t> minor_compact_count_{0};
   std::atomic<long long> last_minor_duration_ms_{0};
+  std::atomic<uint64_t> write_delay_micros_{0};
+  std::atomic<uint64_t> write_stop_micros_{0};
+  // const 的读路径上也要累加
+  mutable std::atomic<uint64_t> read_errors_{0};
+
+  WriteController write_controller_;
 
-  // 写串行
-  std::mutex write_mu_;
-  // 全局状态共享锁
+  // 全局状态共享锁：写入路径持有共享锁并发写 mem_，切换 MemTable 时持独占锁
   mutable std::shared_mutex state_mu_;
 
+  // 还活着的快照。GetSnapshot 持 state_mu_ 共享锁登记，Compaction 准备阶段
+  // 持独占锁读取，保证不会漏掉一个刚拿到序号还没登记的快照
+  mutable std::mutex snapshots_mu_;
+  std::multiset<SequenceNumber> snapshots_;
+
   // 后台线程，用于MinorCompaction
   std::thread background_thread_;
   // cv，用来通知后台进程干活
@@ -89,6 +195,12 @@ class DBImpl {
   bool bg_stopped_;
   // 一个简单的标志位，表示是否有落盘任务待处理
   bool bg_compaction_scheduled_;
+
+  // 定时同步 WAL 的线程，只在 kPeriodic 模式下启动
+  std::thread wal_sync_thread_;
+  std::mutex wal_sync_mu_;
+  std::condition_variable wal_sync_cv_;
+  bool wal_sync_stopped_ = false;
 };
 
 #endif  // NOVAKV_DBIMPL_H
@@ -5,11 +5,28 @@
 #ifndef NOVAKV_DBITERATOR_H
 #define NOVAKV_DBITERATOR_H
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "InternalIterator.h"
+
+class MemTable;
+class SSTableReader;
+
+// 用户看到的迭代器：在多版本的归并流上，按快照序号挑出每个 key 可见的最新版本，
+// 跳过 tombstone。创建时不拷贝数据，只持有底层 MemTable 和 SST 的引用，
+// 停在哪条才拷出哪条；期间的写入、落盘和 Compaction 都不影响它看到的内容
 class DBIterator {
  public:
-  explicit DBIterator(std::vector<std::pair<std::string, std::string>>&& rows);
+  // 迭代器存活期间必须保持有效的底层对象
+  struct Pins {
+    std::vector<std::shared_ptr<MemTable>> memtables;
+    std::vector<std::shared_ptr<SSTableReader>> tables;
+  };
+
+  // 迭代范围是 key >= lower_bound，初始停在 lower_bound 处
+  DBIterator(std::unique_ptr<InternalIterator> iter, SequenceNumber sequence,
+             Pins pins, std::string lower_bound = "");
   void Seek(const std::string& start_key);
   void Next();
   bool Valid() const;
@@ -17,8 +34,18 @@ class DBIterator {
   const std::string& value() const;
 
  private:
-  std::vector<std::pair<std::string, std::string>> rows_;
-  size_t pos_;
+  // 从 iter_ 当前位置往后找第一个可见的 key；skipping 为 true 时
+  // 先跳过 key_ 剩下的版本
+  void FindNextUserEntry(bool skipping);
+
+  // 声明在 iter_ 之前：析构时先销毁迭代器，再放开底层对象
+  Pins pins_;
+  std::unique_ptr<InternalIterator> iter_;
+  SequenceNumber sequence_;
+  std::string lower_bound_;
+  bool valid_ = false;
+  std::string key_;
+  std::string value_;
 };
 
-#endif  // NOVAKV_DBITERATOR_H
\ No newline at end of file
+#endif  // NOVAKV_DBITERATOR_H
@@ -0,0 +1,33 @@
+//
+// Created by 26708 on 2026/3/24.
+//
+// 存储层内部的多版本迭代器：按 (key 升序, sequence 降序) 吐出每一个版本，
+// 包括 tombstone 和被覆盖的旧值。MemTable、SST 各自实现，
+// MergingIterator 把它们合成一路，DBIterator 再按快照挑出用户可见的那一版。
+// key/value 是指向底层存储（Arena、mmap）的视图，只在下一次移动前有效，
+// 调用方要保证底层对象比迭代器活得久。
+
+#ifndef NOVAKV_INTERNALITERATOR_H
+#define NOVAKV_INTERNALITERATOR_H
+
+#include <string_view>
+
+#include "ValueRecord.h"
+
+class InternalIterator {
+ public:
+  virtual ~InternalIterator() = default;
+
+  virtual bool Valid() const = 0;
+  virtual void SeekToFirst() = 0;
+  // 定位到第一个 key >= target 的版本（该 key 最新的那一版）
+  virtual void Seek(std::string_view target) = 0;
+  virtual void Next() = 0;
+
+  virtual std::string_view key() const = 0;
+  virtual SequenceNumber sequence() const = 0;
+  virtual ValueType type() const = 0;
+  virtual std::string_view value() const = 0;
+};
+
+#endif  // NOVAKV_INTERNALITERATOR_H
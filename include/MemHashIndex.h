@@ -0,0 +1,94 @@
+//
+// Created by 26708 on 2026/3/16.
+//
+// MemTable 旁路的点查索引：key 的哈希 -> 跳表节点指针。
+// 定长开放寻址表，槽位是 atomic 指针，插入用 CAS 抢空槽，查找全程无锁。
+// 跳表节点一经插入地址就不再变化（Arena 分配，tombstone 不摘链），
+// 所以索引里只存指针，value 仍然从节点上原子读取。
+
+#ifndef NOVAKV_MEMHASHINDEX_H
+#define NOVAKV_MEMHASHINDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string_view>
+
+template <typename Node>
+class MemHashIndex {
+ public:
+  // 线性探测的最大步数，超过就放弃这个 key，并把索引标记为“不完整”
+  static constexpr size_t kMaxProbe = 16;
+
+  // slots 会向上取整到 2 的幂，方便用位与代替取模
+  explicit MemHashIndex(size_t slots) {
+    capacity_ = 1;
+    while (capacity_ < slots) {
+      capacity_ <<= 1;
+    }
+    mask_ = capacity_ - 1;
+    slots_ = std::make_unique<std::atomic<Node*>[]>(capacity_);
+    for (size_t i = 0; i < capacity_; ++i) {
+      slots_[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  MemHashIndex(const MemHashIndex&) = delete;
+  MemHashIndex& operator=(const MemHashIndex&) = delete;
+
+  // 登记一个已经挂进跳表的节点，可被多个写线程并发调用。
+  // 同一个 key 在跳表里只有一个节点，重复登记直接返回
+  void Insert(Node* node) {
+    const std::string_view key = node->key;
+    size_t pos = Hash(key) & mask_;
+    for (size_t i = 0; i < kMaxProbe; ++i, pos = (pos + 1) & mask_) {
+      Node* expected = slots_[pos].load(std::memory_order_acquire);
+      if (expected == nullptr &&
+          slots_[pos].compare_exchange_strong(expected, node,
+                                              std::memory_order_release,
+                                              std::memory_order_acquire)) {
+        return;
+      }
+      // 空槽被别人抢了，或者本来就有人：同 key 说明已经登记过
+      if (expected->key == key) {
+        return;
+      }
+    }
+    // 探测链太长（表太满或哈希冲突集中），这个 key 只能靠跳表找了
+    complete_.store(false, std::memory_order_release);
+  }
+
+  // 命中返回节点；未命中返回 nullptr，此时需要结合 complete() 判断能否信任
+  Node* Find(std::string_view key) const {
+    size_t pos = Hash(key) & mask_;
+    for (size_t i = 0; i < kMaxProbe; ++i, pos = (pos + 1) & mask_) {
+      Node* node = slots_[pos].load(std::memory_order_acquire);
+      if (node == nullptr) {
+        return nullptr;
+      }
+      if (node->key == key) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  // 所有插入都登记成功时，Find 未命中就等于 key 不在 MemTable 里
+  bool complete() const { return complete_.load(std::memory_order_acquire); }
+
+  // 槽位数组占用的字节数，计入 MemTable 的内存统计
+  size_t MemoryUsage() const { return capacity_ * sizeof(std::atomic<Node*>); }
+
+ private:
+  static size_t Hash(std::string_view key) {
+    return std::hash<std::string_view>{}(key);
+  }
+
+  size_t capacity_;
+  size_t mask_;
+  std::unique_ptr<std::atomic<Node*>[]> slots_;
+  std::atomic<bool> complete_{true};
+};
+
+#endif  // NOVAKV_MEMHASHINDEX_H
@@ -5,79 +5,561 @@
 #ifndef NOVAKV_MEMTABLE_H
 #define NOVAKV_MEMTABLE_H
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <shared_mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
+#include "Arena.h"
+#include "InternalIterator.h"
 #include "Logger.h"
-#include "SkipList.h"
+#include "MemTableRep.h"
+#include "Options.h"
 #include "ValueRecord.h"
 #include "WalHandler.h"
+#include "WriteBatch.h"
 
 class MemTable {
  private:
-  // 顺序很重要：先 WAL，再 Table
+  // 顺序很重要：先 WAL，再 Rep
   // Member Initializer List Order Awareness
-  // 初始化时：先初始化 wal_，再初始化 table_。这样 RecoverFromWal
-  // 执行时，文件句柄已经完全准备好了。 析构时：先销毁 table_，再销毁
+  // 初始化时：先初始化 wal_，再初始化 rep_。这样 RecoverFromWal
+  // 执行时，文件句柄已经完全准备好了。 析构时：先销毁 rep_，再销毁
   // wal_。这保证了在内存索引销毁的过程中，如果还有任何最后的日志要写，wal_
   // 依然是有效的。
   WalHandler wal_;
-  SkipList<std::string, ValueRecord> table_;
-  mutable std::shared_mutex rw_lock_;  // 读写锁
+  // Arena 必须声明在 rep_ 之前：析构时先拆索引结构，再整体归还内存
+  Arena arena_;
+  // Rep 里只存两个“视图”：key 指向 Arena 里的 key 字节，
+  // record 指向这个 key 最新的一条版本记录（版本链的链头）
+  // [Older(8B)][Sequence(8B)][ValueType(1B)][ValueLen(4B)][Value][Key]
+  // Older 指向同一个 key 的上一个版本，链上的序号从新到旧递减
+  std::unique_ptr<MemTableRep> rep_;
+  // 等待写 WAL 的写线程，队首是当前的 leader。
+  // batch 非空时写的是整个 WriteBatch，key/value/type 不用
+  struct LogWriter {
+    // 单条记录
+    LogWriter(const std::string* k, const std::string* v, const ValueType t,
+              const bool s)
+        : key(k), value(v), type(t), sync(s) {}
+    // 整个 WriteBatch
+    LogWriter(const WriteBatch* b, const bool s) : sync(s), batch(b) {}
+
+    const std::string* key = nullptr;
+    const std::string* value = nullptr;
+    ValueType type = ValueType::kValue;
+    bool sync = false;
+    const WriteBatch* batch = nullptr;
+    // 这个写线程的第一条记录的序号，批内其余记录依次加一
+    SequenceNumber ticket = 0;
+    bool done = false;
+    // 这批 WAL 写入（以及要求的同步）是否成功，和 done 一起设置
+    bool ok = false;
+    std::condition_variable cv;
+    // 在 Publish 里等前一个写入公布，和 publish_mu_ 配合使用
+    std::condition_variable publish_cv;
+  };
+  // 只保护写线程队列和序号分配；Rep 的插入和读取各自保证线程安全
+  std::mutex wal_mu_;
+  std::deque<LogWriter*> log_writers_;
+  // 已分配出去的最大序号，分配顺序和 WAL 中的先后顺序一致
+  std::atomic<SequenceNumber> last_sequence_{0};
+  // 已对读者公布的最大序号：它之前的写入全部插进了 Rep，
+  // 按它读就不会看到半批，也不会看到后写的而漏掉先写的
+  std::atomic<SequenceNumber> visible_sequence_{0};
+  std::mutex publish_mu_;
+  // 按序号顺序走完 Publish 的最大序号，由 publish_mu_ 保护。WAL 写失败的
+  // 写入也要走一遍让后面的人排上队，但不推进 visible_sequence_
+  SequenceNumber published_sequence_ = 0;
+  // 还轮不到公布的写线程，以自己的 ticket 登记，由 publish_mu_ 保护
+  std::unordered_map<SequenceNumber, LogWriter*> publish_waiters_;
+
+  // 流水线写：写线程排队时就拿到 ticket（即 WAL 中的位置），随后立刻插入 Rep，
+  // 由专门的 WAL 线程批量写日志，写线程只在返回前等自己那批写完
+  const bool pipelined_write_;
+  std::condition_variable wal_cv_;
+  bool wal_stop_ = false;
+  std::thread wal_thread_;
+
+  using OlderLink = std::atomic<const char*>;
+  static constexpr size_t kSequenceOffset = sizeof(OlderLink);
+  static constexpr size_t kTypeOffset =
+      kSequenceOffset + sizeof(SequenceNumber);
+  static constexpr size_t kRecordHeader = kTypeOffset + 1 + sizeof(uint32_t);
+
+  // 把一个版本连续拷进 Arena：[Older][Sequence][ValueType][ValueLen][Value][Key]
+  // 返回 Arena 中 key 的视图，record 指向记录开头。
+  // 按对齐分配，Older 要当 atomic 指针用
+  std::string_view CopyEntry(const std::string& key,
+                             const SequenceNumber sequence,
+                             const ValueType type, const std::string& value,
+                             const char** record) {
+    const auto val_len = static_cast<uint32_t>(value.size());
+    char* rec = arena_.AllocateAligned(kRecordHeader + val_len + key.size());
+    new (rec) OlderLink(nullptr);
+    std::memcpy(rec + kSequenceOffset, &sequence, sizeof(SequenceNumber));
+    rec[kTypeOffset] = static_cast<char>(type);
+    std::memcpy(rec + kTypeOffset + 1, &val_len, sizeof(uint32_t));
+    std::memcpy(rec + kRecordHeader, value.data(), val_len);
+    char* k = rec + kRecordHeader + val_len;
+    std::memcpy(k, key.data(), key.size());
+    *record = rec;
+    return {k, key.size()};
+  }
+
+  void Insert(const std::string& key, const SequenceNumber sequence,
+              const ValueType type, const std::string& value) {
+    const char* record = nullptr;
+    const std::string_view k = CopyEntry(key, sequence, type, value, &record);
+    rep_->Insert(k, record);
+  }
+
+  static OlderLink& Older(const char* record) {
+    return *reinterpret_cast<OlderLink*>(const_cast<char*>(record));
+  }
+
+  // Rep 的 LinkFn：同一个 key 被多个线程并发写入时，每个版本都按序号留在链上。
+  // 序号更大的成为新链头；否则无锁地插进链中对应的位置。
+  // 这样内存里每个快照看到的值都和重放 WAL 得到的结果一致
+  static bool LinkVersion(const char* head, const char* record) {
+    const SequenceNumber sequence = RecordSequence(record);
+    if (sequence > RecordSequence(head)) {
+      Older(record).store(head, std::memory_order_release);
+      return true;
+    }
+    const char* prev = head;
+    while (true) {
+      const char* next = Older(prev).load(std::memory_order_acquire);
+      if (next != nullptr && RecordSequence(next) >= sequence) {
+        prev = next;
+        continue;
+      }
+      Older(record).store(next, std::memory_order_relaxed);
+      if (Older(prev).compare_exchange_weak(next, record,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        return false;
+      }
+    }
+  }
+
+  // 沿版本链找第一个序号 <= snapshot 的版本
+  static const char* FindVersion(const char* record,
+                                 const SequenceNumber snapshot) {
+    while (record != nullptr && RecordSequence(record) > snapshot) {
+      record = Older(record).load(std::memory_order_acquire);
+    }
+    return record;
+  }
+
+  // 一次组提交最多合并的字节数，避免单个 leader 替别人写太久
+  static constexpr size_t kMaxGroupBytes = 1 << 20;
+
+  static size_t RecordCount(const LogWriter& w) {
+    return w.batch != nullptr ? w.batch->Count() : 1;
+  }
+
+  static size_t WriterBytes(const LogWriter& w) {
+    return w.batch != nullptr ? w.batch->ApproximateSize()
+                              : w.key->size() + w.value->size();
+  }
+
+  void EncodeWriter(std::string* dst, const LogWriter& w) {
+    if (w.batch == nullptr) {
+      wal_.EncodeRecord(dst, *w.key, *w.value, w.type);
+      return;
+    }
+    for (const auto& [key, value] : w.batch->Entries()) {
+      wal_.EncodeRecord(dst, key, value.value, value.type);
+    }
+  }
+
+  // 把一个写线程的记录按序号顺序插进 Rep
+  void Apply(const LogWriter& w) {
+    if (w.batch == nullptr) {
+      Insert(*w.key, w.ticket, w.type, *w.value);
+      return;
+    }
+    SequenceNumber sequence = w.ticket;
+    for (const auto& [key, value] : w.batch->Entries()) {
+      Insert(key, sequence++, value.type, value.value);
+    }
+  }
+
+  // 给写线程分配 RecordCount 个连续的序号，调用方持有 wal_mu_
+  void AssignTickets(LogWriter* w) {
+    w->ticket =
+        last_sequence_.fetch_add(RecordCount(*w), std::memory_order_relaxed) +
+        1;
+  }
+
+  // 插完 Rep 之后按序号顺序公布：等前面的写入都公布了，
+  // 再把可见序号推进到自己的最后一条。并发写入各自插 Rep，只在这里排一次队。
+  // 轮不到的写线程登记后睡在自己的 publish_cv 上，每次公布只唤醒紧接着的
+  // 那一个，不会把所有在等的写线程都叫醒。
+  // WAL 写失败的写入不公布：WAL 一旦失败就不再接受写入，失败的总在成功的
+  // 后面，可见序号停在最后一个成功的写入上
+  void Publish(LogWriter* w) {
+    const SequenceNumber last = w->ticket + RecordCount(*w) - 1;
+    std::unique_lock lock(publish_mu_);
+    if (published_sequence_ != w->ticket - 1) {
+      publish_waiters_.emplace(w->ticket, w);
+      w->publish_cv.wait(lock,
+                         [&] { return published_sequence_ == w->ticket - 1; });
+    }
+    published_sequence_ = last;
+    if (w->ok) {
+      visible_sequence_.store(last, std::memory_order_release);
+    }
+    const auto next = publish_waiters_.find(last + 1);
+    if (next != publish_waiters_.end()) {
+      // 持锁通知：后继拿到锁之前不会返回，它的 LogWriter 此时一定还在
+      next->second->publish_cv.notify_one();
+      publish_waiters_.erase(next);
+    }
+  }
+
+  // 组提交：写线程排队，队首的 leader 按队列顺序给一批写线程分配序号，
+  // 编码成一个缓冲区一次写入 WAL，再唤醒这一批 follower。
+  // 同一时刻只有一个 leader，所以序号顺序 == WAL 顺序。
+  // 一批的记录写进同一次 AddRecords，即同一条 WAL 逻辑记录，回放时不会只剩半批
+  void AppendLog(LogWriter* writer) {
+    LogWriter& w = *writer;
+    std::unique_lock lock(wal_mu_);
+    log_writers_.push_back(&w);
+    while (!w.done && &w != log_writers_.front()) {
+      w.cv.wait(lock);
+    }
+    if (w.done) {
+      return;
+    }
+
+    // 成为 leader：收集一批，写 WAL 期间放开锁，让后来者继续排队
+    std::string batch;
+    bool batch_sync = false;
+    LogWriter* last = nullptr;
+    for (LogWriter* writer : log_writers_) {
+      if (last != nullptr && batch.size() >= kMaxGroupBytes) {
+        break;
+      }
+      AssignTickets(writer);
+      if (last == nullptr) {
+        wal_.BeginBatch(&batch, writer->ticket);
+      }
+      EncodeWriter(&batch, *writer);
+      // 批里只要有一个要求同步，整批一起同步
+      batch_sync = batch_sync || writer->sync;
+      last = writer;
+    }
+    lock.unlock();
+    const bool ok = wal_.AddRecords(batch, batch_sync);
+    lock.lock();
+
+    // 整批共用一次写入，成败也一起告诉每个 follower
+    while (true) {
+      LogWriter* ready = log_writers_.front();
+      log_writers_.pop_front();
+      ready->ok = ok;
+      ready->done = true;
+      if (ready != &w) {
+        ready->cv.notify_one();
+      }
+      if (ready == last) {
+        break;
+      }
+    }
+    // 把 leader 交给下一批的队首
+    if (!log_writers_.empty()) {
+      log_writers_.front()->cv.notify_one();
+    }
+  }
+
+  // 流水线模式下的 WAL 线程：每次把队列里攒下的写入整批取走，
+  // 放开锁之后编码、写盘，写线程在此期间继续排队和插入 Rep
+  void WalWriterLoop() {
+    std::vector<LogWriter*> writers;
+    std::string batch;
+    std::unique_lock lock(wal_mu_);
+    while (true) {
+      wal_cv_.wait(lock, [this] { return wal_stop_ || !log_writers_.empty(); });
+      if (log_writers_.empty()) {
+        return;
+      }
+      size_t bytes = 0;
+      while (!log_writers_.empty() &&
+             (writers.empty() || bytes < kMaxGroupBytes)) {
+        LogWriter* writer = log_writers_.front();
+        log_writers_.pop_front();
+        bytes += WriterBytes(*writer);
+        writers.push_back(writer);
+      }
+      lock.unlock();
+
+      // 写线程要等到 done 才返回，所以 key/value 指针在这里一直有效
+      batch.clear();
+      wal_.BeginBatch(&batch, writers.front()->ticket);
+      bool batch_sync = false;
+      for (const LogWriter* writer : writers) {
+        EncodeWriter(&batch, *writer);
+        batch_sync = batch_sync || writer->sync;
+      }
+      const bool ok = wal_.AddRecords(batch, batch_sync);
+
+      lock.lock();
+      for (LogWriter* writer : writers) {
+        writer->ok = ok;
+        writer->done = true;
+        writer->cv.notify_one();
+      }
+      writers.clear();
+    }
+  }
+
+  // 先写日志再改内存；流水线模式下日志交给 WAL 线程，插入 Rep 和写盘重叠进行，
+  // 但要等这批写入进了 WAL（需要时已同步）才公布给读者并返回：
+  // 读者看到过的值，崩溃后回放 WAL 一定还在。WAL 写失败时返回 false
+  bool Write(LogWriter* w) {
+    if (!pipelined_write_) {
+      AppendLog(w);
+      // 跳表实现走无锁 CAS，不同 key 的写入可以并行
+      if (w->ok) {
+        Apply(*w);
+      }
+      Publish(w);
+      return w->ok;
+    }
+
+    {
+      // 在锁内分配序号并入队，序号顺序 == 队列顺序 == WAL 顺序
+      std::lock_guard lock(wal_mu_);
+      AssignTickets(w);
+      log_writers_.push_back(w);
+      if (log_writers_.size() == 1) {
+        wal_cv_.notify_one();
+      }
+    }
+    Apply(*w);
+    {
+      std::unique_lock lock(wal_mu_);
+      w->cv.wait(lock, [w] { return w->done; });
+    }
+    // 失败时记录已经插进了 Rep，但序号不会公布，读者看不到。
+    // 这张表之后也不会再落盘，由 DBImpl 保证
+    Publish(w);
+    return w->ok;
+  }
+
+  static SequenceNumber RecordSequence(const char* record) {
+    SequenceNumber sequence;
+    std::memcpy(&sequence, record + kSequenceOffset, sizeof(SequenceNumber));
+    return sequence;
+  }
+
+  static ValueType RecordType(const char* record) {
+    return static_cast<ValueType>(record[kTypeOffset]);
+  }
+
+  static std::string_view RecordValue(const char* record) {
+    uint32_t val_len;
+    std::memcpy(&val_len, record + kTypeOffset + 1, sizeof(uint32_t));
+    return {record + kRecordHeader, val_len};
+  }
+
+  static void DecodeRecord(const char* record, ValueRecord& value) {
+    value.type = RecordType(record);
+    value.value.assign(RecordValue(record));
+    value.sequence = RecordSequence(record);
+  }
 
  public:
   // MemTable(int max_level = 16, const std::string& wal_file) :
   // table_(max_level), wal_(wal_file) {}
   // 当构造函数中既有带默认值的参数，又有必须传递的参数时，C++
   // 规定：默认实参必须从右向左排列。
-  MemTable(const std::string& wal_file, int max_level = 16)
-      : wal_(wal_file), table_(max_level) {}
-
-  // 插入或更新
-  void Put(const std::string& key, const ValueRecord& value) {
-    // 加个写锁，确保同一时间只有一个线程在修改SkipList
-    std::unique_lock lock(rw_lock_);
-    // 关键：先写日志，再改内存！
-    wal_.AddLog(key, value.value, value.type);
-    // 加锁后直接调用insert方式
-    table_.insert_element(key, value);
-  }
-  // 查询
-  bool Get(const std::string& key, ValueRecord& value) const {
-    // 加个读锁，确保同一时间多个线程可以同时读
-    std::shared_lock lock(rw_lock_);
-    return table_.search_element(key, value);
+  // hash_index_slots > 0 时额外建一个点查哈希索引（仅跳表实现支持），只影响
+  // Get，有序遍历（落盘、迭代器）仍然走跳表。rep_type 选择底层数据结构，
+  // wal_options 控制 WAL 文件的预分配和复用，pipelined_write 为 true 时
+  // 启动一个专门写 WAL 的线程
+  MemTable(const std::string& wal_file, int max_level = 16,
+           size_t hash_index_slots = 0,
+           MemTableRepType rep_type = MemTableRepType::kSkipList,
+           const WalOpenOptions& wal_options = WalOpenOptions(),
+           const bool pipelined_write = false)
+      : wal_(wal_file, wal_options),
+        rep_(MemTableRep::Create(rep_type, &arena_, &MemTable::LinkVersion,
+                                 max_level, hash_index_slots)),
+        pipelined_write_(pipelined_write) {
+    if (pipelined_write_) {
+      wal_thread_ = std::thread(&MemTable::WalWriterLoop, this);
+    }
+  }
+
+  ~MemTable() {
+    if (wal_thread_.joinable()) {
+      {
+        std::lock_guard lock(wal_mu_);
+        wal_stop_ = true;
+      }
+      wal_cv_.notify_one();
+      wal_thread_.join();
+    }
+  }
+
+  MemTable(const MemTable&) = delete;
+  MemTable& operator=(const MemTable&) = delete;
+
+  // 对 Rep 有序迭代器的一层包装，负责把 Arena 里的 value 记录解码出来。
+  // 每个 key 只给出链头（最新写入的版本），不看快照
+  class Iterator {
+   public:
+    explicit Iterator(std::unique_ptr<MemTableRep::Iterator> it)
+        : it_(std::move(it)) {}
+
+    bool Valid() const { return it_->Valid(); }
+    void Next() { it_->Next(); }
+    void Seek(const std::string_view target) { it_->Seek(target); }
+    std::string_view key() const { return it_->key(); }
+    ValueType type() const { return RecordType(it_->record()); }
+    std::string_view value() const { return RecordValue(it_->record()); }
+    SequenceNumber sequence() const { return RecordSequence(it_->record()); }
+
+   private:
+    std::unique_ptr<MemTableRep::Iterator> it_;
+  };
+
+  // 遍历所有版本：key 升序，同 key 沿版本链从新到旧。
+  // 落盘和 DBIterator 都通过它消费，由调用方按快照取舍
+  class VersionIterator : public InternalIterator {
+   public:
+    explicit VersionIterator(std::unique_ptr<MemTableRep::Iterator> it)
+        : it_(std::move(it)) {
+      SeekToFirst();
+    }
+
+    bool Valid() const override { return record_ != nullptr; }
+    void SeekToFirst() override { Seek({}); }
+    void Seek(const std::string_view target) override {
+      it_->Seek(target);
+      record_ = it_->Valid() ? it_->record() : nullptr;
+    }
+    void Next() override {
+      record_ = Older(record_).load(std::memory_order_acquire);
+      if (record_ == nullptr) {
+        it_->Next();
+        record_ = it_->Valid() ? it_->record() : nullptr;
+      }
+    }
+    std::string_view key() const override { return it_->key(); }
+    SequenceNumber sequence() const override {
+      return RecordSequence(record_);
+    }
+    ValueType type() const override { return RecordType(record_); }
+    std::string_view value() const override { return RecordValue(record_); }
+
+   private:
+    std::unique_ptr<MemTableRep::Iterator> it_;
+    const char* record_ = nullptr;
+  };
+
+  // 插入或更新，可被多个线程并发调用。sync 为 true 时返回前 WAL 已落盘。
+  // WAL 写入或同步失败时返回 false，这次写入读者看不到
+  bool Put(const std::string& key, const ValueRecord& value,
+           const bool sync = false) {
+    LogWriter w(&key, &value.value, value.type, sync);
+    return Write(&w);
+  }
+  // 原子写入一批记录，批内记录占用连续的序号，整批插完才一起公布，
+  // 按 VisibleSequence() 读的读者不会看到半批
+  bool Write(const WriteBatch& batch, const bool sync = false) {
+    if (batch.Count() == 0) {
+      return true;
+    }
+    LogWriter w(&batch, sync);
+    return Write(&w);
+  }
+  // 查询序号 <= snapshot 的最新版本：跳表实现无锁，和并发写入同时进行；
+  // key 以视图传入，全程不拷贝。默认看所有已插入的版本（包括还没公布的）
+  bool Get(const std::string_view key, ValueRecord& value,
+           const SequenceNumber snapshot = kMaxSequenceNumber) const {
+    const char* record = nullptr;
+    if (!rep_->Get(key, &record)) {
+      return false;
+    }
+    record = FindVersion(record, snapshot);
+    if (record == nullptr) {
+      return false;
+    }
+    DecodeRecord(record, value);
+    return true;
+  }
+  // 零拷贝版 Get：value 指向 Arena 里的记录，MemTable 活着就一直有效。
+  // *sequence 是找到的版本的序号
+  bool GetView(const std::string_view key, ValueType* type,
+               SequenceNumber* sequence, std::string_view* value,
+               const SequenceNumber snapshot = kMaxSequenceNumber) const {
+    const char* record = nullptr;
+    if (!rep_->Get(key, &record)) {
+      return false;
+    }
+    record = FindVersion(record, snapshot);
+    if (record == nullptr) {
+      return false;
+    }
+    *type = RecordType(record);
+    *sequence = RecordSequence(record);
+    *value = RecordValue(record);
+    return true;
   }
   // 删除
   bool Remove(const std::string& key) {
-    // 同样要加写锁
-    std::unique_lock lock(rw_lock_);
-    // 关键：先写日志，再改内存！
     // Put 写 kValue, Remove 写 kDeletion
-    wal_.AddLog(key, "", ValueType::kDeletion);
     // remove 不再物理删除节点，而是写入tombstone
-    table_.insert_element(key, {ValueType::kDeletion, ""});
-    return true;
+    static const std::string kEmpty;
+    LogWriter w(&key, &kEmpty, ValueType::kDeletion, false);
+    return Write(&w);
   }
 
   // 获取当前数量
-  int Count() const {
-    std::shared_lock lock(rw_lock_);
-    return table_.size();
+  int Count() const { return rep_->Count(); }
+
+  Iterator GetIterator() const { return Iterator(rep_->NewIterator()); }
+
+  std::unique_ptr<InternalIterator> NewVersionIterator() const {
+    return std::make_unique<VersionIterator>(rep_->NewIterator());
+  }
+
+  // 已公布的最大序号，读者拿它当“当前”快照
+  SequenceNumber VisibleSequence() const {
+    return visible_sequence_.load(std::memory_order_acquire);
   }
 
-  auto GetIterator() {
-    // 记得加读锁，虽然此时 imm_ 是只读的，但养成习惯没坏处
-    return table_.begin();
+  // 新表接着上一张表（或恢复出的数据）的序号往下编，只能在写入前调用
+  void SetLastSequence(const SequenceNumber sequence) {
+    last_sequence_.store(sequence, std::memory_order_relaxed);
+    published_sequence_ = sequence;
+    visible_sequence_.store(sequence, std::memory_order_release);
   }
 
   using SnapshotRow = std::pair<std::string, ValueRecord>;
-  auto Snapshot() const {
-    std::shared_lock lock(rw_lock_);
+  // 只拷贝 key >= start_key 的部分，范围扫描不必复制起点之前的数据
+  auto Snapshot(const std::string_view start_key = {}) const {
     std::vector<SnapshotRow> snap_result;
-    auto it = table_.begin();
+    auto it = GetIterator();
+    it.Seek(start_key);
     while (it.Valid()) {
-      snap_result.emplace_back(it.key(), it.value());
+      snap_result.emplace_back(
+          std::string(it.key()),
+          ValueRecord{it.type(), std::string(it.value()),
+                      it.sequence()});
       it.Next();
     }
     return snap_result;
@@ -87,18 +569,34 @@ class MemTable {
   // 1. 获取 WalHandler 指针，方便 DBImpl 调用 LoadLog
   WalHandler* GetWalHandler() { return &wal_; }
 
-  void ApplyWithoutWal(const std::string& key, const ValueRecord& value) {
-    std::unique_lock lock(rw_lock_);
-    table_.insert_element(key, value);
+  // 把 WAL 中已写入的部分 fdatasync 到磁盘
+  bool SyncWal() { return wal_.Sync(); }
+
+  // WAL 写入或同步失败过：表里可能有没公布的记录，不能再写也不能落盘，
+  // 已确认的写入留给下次启动时回放 WAL
+  bool WalFailed() const { return wal_.Failed(); }
+
+  // 单线程使用（恢复、测试）：sequence 为 0 时接着分配下一个序号，
+  // 否则沿用 WAL 里记下的序号，写完立刻公布
+  void ApplyWithoutWal(const std::string& key, const ValueRecord& value,
+                       SequenceNumber sequence = 0) {
+    SequenceNumber last = last_sequence_.load(std::memory_order_relaxed);
+    if (sequence == 0) {
+      sequence = last + 1;
+    }
+    Insert(key, sequence, value.type, value.value);
+    last = std::max(last, sequence);
+    last_sequence_.store(last, std::memory_order_relaxed);
+    published_sequence_ = last;
+    visible_sequence_.store(last, std::memory_order_release);
   }
 
-  // 4. 获取内存占用估算 (字节)
+  // 4. 获取内存占用 (字节)
   // 这是一个硬核指标，用于触发 Minor Compaction
+  // 节点、key、value 全部在 Arena 上，Arena 申请过的块总大小就是真实占用；
+  // 哈希索引的槽位数组、vector 的 Entry 数组单独分配，也要算进去
   size_t ApproximateMemoryUsage() const {
-    // 粗略计算：SkipList 节点数 * (Key平均大小 + Value平均大小 + 指针开销)
-    // 简单起见，可以先返回 table_.size() * 100 (假设平均每条 100 字节)
-    // 或者在 SkipList 里维护一个精确的 byte_counter
-    return table_.size() * 128;
+    return arena_.MemoryUsage() + rep_->MemoryUsage();
   }
 
   // 获取Path
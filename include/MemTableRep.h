@@ -0,0 +1,117 @@
+//
+// Created by 26708 on 2026/3/19.
+//
+// MemTable 的底层数据结构抽象。MemTable 负责 WAL、Arena 和记录编码，
+// Rep 只管 “Arena 里的 key 视图 -> Arena 里的记录指针” 怎么存、怎么找、怎么有序遍历。
+
+#ifndef NOVAKV_MEMTABLEREP_H
+#define NOVAKV_MEMTABLEREP_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "Arena.h"
+#include "MemHashIndex.h"
+#include "Options.h"
+#include "SkipList.h"
+
+class MemTableRep {
+ public:
+  // 同一个 key 的多个版本由 MemTable 在记录里串成链，Rep 只保存链头。
+  // key 已存在时调用 link(head, record)：返回 true 表示 record 更新，
+  // 已经把 head 挂在自己后面，应当替换成新链头；返回 false 表示 record
+  // 已被插进链的中间，链头不变。并发插入时 link 可能对同一条记录调用多次
+  using LinkFn = bool (*)(const char* head, const char* record);
+
+  // 有序迭代器：key 升序，每个 key 只出现一次（版本链的链头）
+  class Iterator {
+   public:
+    virtual ~Iterator() = default;
+    virtual bool Valid() const = 0;
+    virtual void Next() = 0;
+    // 定位到第一个 key >= target 的位置
+    virtual void Seek(std::string_view target) = 0;
+    virtual std::string_view key() const = 0;
+    virtual const char* record() const = 0;
+  };
+
+  virtual ~MemTableRep() = default;
+
+  // 可被多个写线程并发调用
+  virtual void Insert(std::string_view key, const char* record) = 0;
+  virtual bool Get(std::string_view key, const char** record) const = 0;
+  virtual int Count() const = 0;
+  virtual std::unique_ptr<Iterator> NewIterator() const = 0;
+  // Arena 之外额外占用的内存
+  virtual size_t MemoryUsage() const = 0;
+
+  static std::unique_ptr<MemTableRep> Create(MemTableRepType type,
+                                             Arena* arena, LinkFn link,
+                                             int max_level,
+                                             size_t hash_index_slots);
+};
+
+// 默认实现：无锁跳表，可选挂一个点查哈希索引
+class SkipListRep : public MemTableRep {
+ public:
+  using Table = SkipList<std::string_view, const char*>;
+  using HashIndex = MemHashIndex<Table::Node>;
+
+  SkipListRep(Arena* arena, LinkFn link, int max_level,
+              size_t hash_index_slots);
+
+  void Insert(std::string_view key, const char* record) override;
+  bool Get(std::string_view key, const char** record) const override;
+  int Count() const override { return table_.size(); }
+  std::unique_ptr<Iterator> NewIterator() const override;
+  size_t MemoryUsage() const override {
+    return hash_index_ ? hash_index_->MemoryUsage() : 0;
+  }
+
+ private:
+  LinkFn link_;
+  Table table_;
+  // 可选的点查哈希索引，为空表示只走跳表
+  std::unique_ptr<HashIndex> hash_index_;
+};
+
+// 批量导入用：写入只是往 vector 尾部追加，读或落盘时才排序去重一次。
+// 写入成本远低于跳表，代价是写入期间的点查要先排序，适合只写不读的场景
+class VectorRep : public MemTableRep {
+ public:
+  explicit VectorRep(LinkFn link) : link_(link) {}
+
+  void Insert(std::string_view key, const char* record) override;
+  bool Get(std::string_view key, const char** record) const override;
+  // 排序前可能把同一个 key 的多个版本都算进去
+  int Count() const override {
+    return count_.load(std::memory_order_relaxed);
+  }
+  std::unique_ptr<Iterator> NewIterator() const override;
+  size_t MemoryUsage() const override {
+    return bytes_.load(std::memory_order_relaxed);
+  }
+
+  struct Entry {
+    std::string_view key;
+    const char* record;
+  };
+
+ private:
+  // 调用方持有 mu_：按 key 排序，同 key 的记录串进同一条版本链
+  void SortLocked() const;
+
+  LinkFn link_;
+  mutable std::mutex mu_;
+  mutable std::vector<Entry> entries_;
+  // entries_ 当前是否已经有序且无重复
+  mutable bool sorted_ = true;
+  mutable std::atomic<int> count_{0};
+  std::atomic<size_t> bytes_{0};
+};
+
+#endif  // NOVAKV_MEMTABLEREP_H
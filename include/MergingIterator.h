@@ -0,0 +1,39 @@
+//
+// Created by 26708 on 2026/3/24.
+//
+
+#ifndef NOVAKV_MERGINGITERATOR_H
+#define NOVAKV_MERGINGITERATOR_H
+
+#include <memory>
+#include <vector>
+
+#include "InternalIterator.h"
+
+// 把若干个多版本迭代器归并成一路，顺序为 (key 升序, sequence 降序)。
+// children 按从新到旧排列（活跃 MemTable、不可变 MemTable、L0、L1），
+// key 和 sequence 都相同时（旧格式文件的序号都是 0）排在前面的孩子优先。
+// 孩子只有十几个，每次线性挑最小的，不值得维护堆
+class MergingIterator : public InternalIterator {
+ public:
+  explicit MergingIterator(
+      std::vector<std::unique_ptr<InternalIterator>> children);
+
+  bool Valid() const override { return current_ != nullptr; }
+  void SeekToFirst() override;
+  void Seek(std::string_view target) override;
+  void Next() override;
+
+  std::string_view key() const override { return current_->key(); }
+  SequenceNumber sequence() const override { return current_->sequence(); }
+  ValueType type() const override { return current_->type(); }
+  std::string_view value() const override { return current_->value(); }
+
+ private:
+  void FindSmallest();
+
+  std::vector<std::unique_ptr<InternalIterator>> children_;
+  InternalIterator* current_ = nullptr;
+};
+
+#endif  // NOVAKV_MERGINGITERATOR_H
@@ -0,0 +1,97 @@
+//
+// Tunable knobs for DBImpl.
+//
+
+#ifndef NOVAKV_OPTIONS_H
+#define NOVAKV_OPTIONS_H
+
+#include <cstddef>
+
+// MemTable 的底层数据结构
+enum class MemTableRepType {
+  kSkipList,  // 默认：无锁跳表，读写均衡
+  kVector,    // 批量导入：只追加，读或落盘时排序一次
+};
+
+// WAL 的落盘策略，在延迟和掉电不丢数据之间取舍
+enum class WalSyncMode {
+  kNone,        // 只写进内核页缓存：进程崩溃不丢，掉电可能丢
+  kEveryWrite,  // 每次（组）提交都 fdatasync，掉电也不丢，延迟最高
+  kPeriodic,    // 后台定时 fdatasync，或者累计写满一定字节时同步一次
+};
+
+class Snapshot;
+
+// 单次读取（Get / NewIterator）的选项
+struct ReadOptions {
+  // 非空时按这个快照读，看不到快照之后的写入；为空时读当前最新的数据
+  const Snapshot* snapshot = nullptr;
+};
+
+// 单次写入的选项
+struct WriteOptions {
+  // 为 true 时这次写入返回前一定已经 fdatasync，不管 DB 的 wal_sync_mode
+  bool sync = false;
+};
+
+struct DBOptions {
+  // 活跃 MemTable 的 Arena 实际占用达到该字节数后切换为 imm 并落盘。
+  // 按字节而不是按条数：大 value 不会撑出巨型 MemTable，小 value 也不会频繁落盘
+  size_t write_buffer_size = 4 * 1024 * 1024;
+
+  // 待落盘的只读 MemTable 最多排多少张（至少为 1）。
+  // 后台落盘跟不上时先排队吸收写入突发，队列排满了写线程才会等待
+  size_t max_immutable_memtables = 4;
+
+  // 为每个 MemTable 额外建一个哈希索引，热点 key 的点查从 O(log n) 变成 O(1)。
+  // 槽位数按 write_buffer_size / 64 估算，槽位数组也计入 write_buffer_size
+  bool memtable_hash_index = false;
+
+  // 夜间批量导入这类只写不读的场景可以换成 kVector
+  MemTableRepType memtable_rep = MemTableRepType::kSkipList;
+
+  WalSyncMode wal_sync_mode = WalSyncMode::kNone;
+  // kPeriodic 下后台线程的同步间隔
+  size_t wal_sync_interval_ms = 1000;
+  // kPeriodic 下未同步的字节数达到该值就在写路径上同步一次，0 表示只按时间
+  size_t wal_bytes_per_sync = 0;
+
+  // 新 WAL 打开时按 write_buffer_size 的 1.25 倍 fallocate 预留磁盘空间，
+  // 写入过程中不用再一块块地分配
+  bool wal_preallocate = true;
+
+  // 落盘后的旧 WAL 最多留多少个等着复用（改名后从头覆盖写），0 表示直接删除。
+  // 复用的文件块已经分配好、长度也够，切换 MemTable 时省掉创建文件和分配空间，
+  // fdatasync 也不用再更新文件长度
+  size_t recycle_wal_files = 0;
+
+  // 流水线写：每张 MemTable 配一个专门写 WAL 的线程，写线程拿到 WAL 位置后
+  // 立即插入 MemTable，和上一批日志的写盘重叠；返回时机不变，仍然等日志写完
+  bool pipelined_write = false;
+
+  // L0 文件数达到该值时把整个 L0 合并进 L1（至少为 1）
+  size_t level0_compaction_trigger = 2;
+
+  // 写入限速：下面三类积压任何一类超过软上限就开始限速，超过硬上限就停写，
+  // 直到后台把它降回去。字节类的上限填 0 表示不检查
+  size_t level0_slowdown_writes_trigger = 8;
+  size_t level0_stop_writes_trigger = 12;
+  // 待落盘的 imm 总字节数。停写之外，imm 张数还受 max_immutable_memtables 限制
+  size_t pending_flush_slowdown_bytes = 8 * 1024 * 1024;
+  size_t pending_flush_stop_bytes = 0;
+  // 等着 L0->L1 合并的 L0 文件字节数（L0 文件数没到触发值时算 0）
+  size_t pending_compaction_slowdown_bytes = 64 * 1024 * 1024;
+  size_t pending_compaction_stop_bytes = 256 * 1024 * 1024;
+  // 刚进入限速时的写入速率（字节/秒），积压越接近硬上限降得越低
+  size_t delayed_write_rate = 16 * 1024 * 1024;
+
+  // SST 数据块缓存的字节数，按 LRU 淘汰，0 表示不缓存、每次都从 mmap 解析。
+  // 缓存的是解析好的块，内存用量由它控制，不再随页缓存被 Compaction 挤掉
+  size_t block_cache_capacity = 8 * 1024 * 1024;
+
+  // 同时打开的 SST 个数上限（至少为 1）。启动时只读 Footer，SST 在第一次
+  // 被读到时才打开（mmap、读索引和布隆过滤器），超过上限按 LRU 关掉最久没用的
+  size_t max_open_files = 1000;
+};
+
+#endif  // NOVAKV_OPTIONS_H
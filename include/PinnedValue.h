@@ -0,0 +1,42 @@
+//
+// Created by 26708 on 2026/3/28.
+//
+// Get 的零拷贝结果：value 直接指向 MemTable 的 Arena、SST 的 mmap 或缓存里的
+// 数据块，同时持有那个对象的引用，PinnedValue 析构或 Reset 之前 value 一直有效。
+// pin 住期间底层内存不会释放：落盘后的 MemTable、被 Compaction 删掉的 SST
+// 都要等它放手，所以用完（比如编码进网络缓冲）就该尽快释放。
+
+#ifndef NOVAKV_PINNEDVALUE_H
+#define NOVAKV_PINNEDVALUE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+class PinnedValue {
+ public:
+  PinnedValue() = default;
+
+  std::string_view value() const { return value_; }
+  size_t size() const { return value_.size(); }
+  std::string ToString() const { return std::string(value_); }
+
+  // owner 是让 value 指向的内存保持有效的对象
+  void Pin(const std::string_view value, std::shared_ptr<const void> owner) {
+    value_ = value;
+    owner_ = std::move(owner);
+  }
+
+  void Reset() {
+    value_ = {};
+    owner_.reset();
+  }
+
+ private:
+  std::string_view value_;
+  std::shared_ptr<const void> owner_;
+};
+
+#endif  // NOVAKV_PINNEDVALUE_H
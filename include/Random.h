@@ -0,0 +1,64 @@
+//
+// Created by 26708 on 2026/3/18.
+//
+// 轻量伪随机数：xorshift64*，每个线程一份，不加锁、不分配内存。
+// 跳表抽层高只需要“每一位独立、等概率”的随机比特，不需要 mt19937 的统计质量。
+
+#ifndef NOVAKV_RANDOM_H
+#define NOVAKV_RANDOM_H
+
+#include <cstdint>
+#include <random>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+class Random {
+ public:
+  explicit Random(const uint64_t seed)
+      : state_(seed != 0 ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+  uint64_t Next() {
+    uint64_t x = state_;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    state_ = x;
+    return x * 0x2545F4914F6CDD1DULL;
+  }
+
+  // 按 p = 1/2 的几何分布返回 [1, max_height] 之间的高度：
+  // 随机字的末尾连续 0 的个数就是“连续抛硬币都朝上”的次数，一条指令算完。
+  // 把第 max_height - 1 位强制置 1，保证结果不会超过上限
+  int NextHeight(const int max_height) {
+    const uint64_t word = Next() | (uint64_t{1} << (max_height - 1));
+    return 1 + CountTrailingZeros(word);
+  }
+
+  // 当前线程独享的实例，首次使用时用 random_device 播种
+  static Random& ThreadLocal() {
+    thread_local Random rng(SeedFromDevice());
+    return rng;
+  }
+
+ private:
+  static uint64_t SeedFromDevice() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+  }
+
+  static int CountTrailingZeros(const uint64_t word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+  }
+
+  uint64_t state_;
+};
+
+#endif  // NOVAKV_RANDOM_H
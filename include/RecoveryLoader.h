@@ -5,26 +5,43 @@
 #ifndef NOVAKV_RECOVERYLOADER_H
 #define NOVAKV_RECOVERYLOADER_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "CompactionEngine.h"
 #include "ManifestManager.h"
 #include "MemTable.h"
 #include "SSTableReader.h"
+#include "TableCache.h"
 
 class RecoveryLoader {
  public:
   RecoveryLoader(std::string db_path, ManifestManager &manifest_manager,
-                 std::vector<std::vector<SSTableReader *> > &levels);
+                 std::vector<std::vector<FileMetaData> > &levels,
+                 TableCache &table_cache,
+                 const CompactionEngine &compaction_engine);
 
-  void RecoverFromWals(MemTable *mem) const;
+  // 回放所有 live WAL：线程池并行解析、校验，按文件号顺序应用到临时
+  // MemTable，每超过 write_buffer_size 就落一张 L0，回放完剩下的也落盘，
+  // 全部成功后删除这些 WAL。落盘失败返回 false，WAL 保留到下次启动。
+  // 需要先 LoadSSTables；last_sequence 返回 SST 和 WAL 里最大的序号，
+  // 新的写入从它之后继续编号
+  bool RecoverFromWals(size_t write_buffer_size,
+                       SequenceNumber *last_sequence) const;
+  // 按 manifest 登记各层的 SST。只读每个文件的 Footer，不打开 reader
   void LoadSSTables() const;
   void InitNextFileNumberFromDisk() const;
 
  private:
+  // 把回放出的 MemTable 写成 L0 SST 并登记到 manifest
+  bool FlushRecovered(MemTable *mem) const;
+
   std::string db_path_;
   ManifestManager &manifest_manager_;
-  std::vector<std::vector<SSTableReader *> > &levels_;
+  std::vector<std::vector<FileMetaData> > &levels_;
+  TableCache &table_cache_;
+  const CompactionEngine &compaction_engine_;
 };
 
 #endif  // NOVAKV_RECOVERYLOADER_H
@@ -6,6 +6,7 @@
 #define NOVAKV_SSTABLEBUILDER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "BlockBuilder.h"
@@ -19,8 +20,9 @@ class SSTableBuilder {
   explicit SSTableBuilder(WritableFile* file);
   ~SSTableBuilder() = default;
 
-  // 核心接口：添加一条数据
-  void Add(const std::string& key, const std::string& value, ValueType type);
+  // 核心接口：添加一条数据。key 升序，同一个 key 的多个版本按序号从新到旧
+  void Add(std::string_view key, std::string_view value, ValueType type,
+           SequenceNumber sequence = 0);
 
   // 将内存里剩下的数据全部刷入磁盘，并写下索引和 Footer
   void Finish();
@@ -33,6 +35,8 @@ class SSTableBuilder {
   WritableFile* file_;
   BlockBuilder data_block_;
   std::string last_key_;
+  std::string internal_key_;  // [Key][Sequence] 的拼接缓冲，避免每条都分配
+  SequenceNumber max_sequence_ = 0;
   std::vector<IndexEntry> index_entries_;
   std::vector<std::string> keys_;  // 暂存所有加入的 Key，用于生成过滤器
   BlockHandle filter_handle_;      // 记录过滤器在文件中的位置
@@ -5,30 +5,77 @@
 #ifndef NOVAKV_SSTABLEREADER_H
 #define NOVAKV_SSTABLEREADER_H
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "Block.h"
+#include "BlockCache.h"
+#include "InternalIterator.h"
+#include "PinnedValue.h"
 #include "Storage.h"
 #include "ValueRecord.h"
 
 class SSTableReader {
  public:
   // 静态工厂方法：执行文件打开、mmap 和魔数校验
-  // 成功返回指针，失败返回 nullptr
-  static SSTableReader* Open(const std::string& filename);
+  // 成功返回指针，失败返回 nullptr。
+  // cache 非空时数据块经由它读取，file_number 是块在缓存里的 key 的一部分
+  static SSTableReader* Open(const std::string& filename,
+                             uint64_t file_number = 0,
+                             std::shared_ptr<BlockCache> cache = nullptr);
+
+  // 只读文件末尾的 Footer，不 mmap、不读索引和过滤器。
+  // 启动时用它登记 SST，真正的打开留给 TableCache 按需做
+  static bool ReadFileFooter(const std::string& filename, Footer* footer,
+                             uint64_t* file_size);
 
   ~SSTableReader();
 
+  // 文件被删除时调用，把它在块缓存里的块尽早让出来
+  void EraseCachedBlocks() const;
+
   // 查询 Key
   bool Get(const std::string& key, std::string* value);
-  // 类型感知 Get
-  bool GetRecord(const std::string& key, ValueRecord* record);
+  // 类型感知 Get：取序号 <= snapshot 的最新版本
+  bool GetRecord(const std::string& key, ValueRecord* record,
+                 SequenceNumber snapshot = kMaxSequenceNumber) const;
+  // 零拷贝版 GetRecord：value 直接指向块数据并 pin 住。块来自缓存时 pin
+  // 那一块，否则指向 mmap，pin 的是 owner——调用方持有的这个 reader 的引用。
+  // 找到 tombstone 时也返回 true，*type 为 kDeletion。
+  // *sequence 是找到的版本的序号
+  bool GetPinned(const std::string& key, SequenceNumber snapshot,
+                 const std::shared_ptr<const void>& owner, ValueType* type,
+                 SequenceNumber* sequence, PinnedValue* value) const;
 
-  // 遍历/导出
+  // 遍历/导出：每个版本回调一次，同 key 从新到旧
   void ForEach(const std::function<void(const std::string&, const std::string&,
                                         ValueType)>& cb) const;
 
+  // 遍历所有版本，key/value 指向块数据，不拷贝。迭代器不能比 reader 活得久。
+  // fill_cache 为 false 时未命中的块不放进缓存（Compaction 扫全表用），
+  // 免得把点查的热块挤出去
+  std::unique_ptr<InternalIterator> NewIterator(bool fill_cache = true) const;
+
+  // 文件里最大的序号，旧格式文件为 0
+  SequenceNumber MaxSequence() const { return footer_.max_sequence; }
+
+  size_t FileSize() const { return file_size_; }
+
  private:
+  class Iterator;
+
+  const char* BlockData(const BlockHandle& handle) const {
+    return static_cast<const char*>(data_) + handle.offset;
+  }
+
+  // 用过滤器和索引找到 key 所在的数据块，肯定不在这个文件里时返回 nullptr
+  const BlockHandle* LocateBlock(const std::string& key) const;
+
+  // 先查块缓存，未命中再从 mmap 解析；fill_cache 决定解析出的块要不要缓存
+  std::shared_ptr<const Block> ReadBlock(const BlockHandle& handle,
+                                         bool fill_cache) const;
+
   // 私有构造函数，防止外部直接 new
   SSTableReader();
 
@@ -42,6 +89,9 @@ class SSTableReader {
   void* data_;        // mmap 映射后的起始地址
   size_t file_size_;  // 文件大小
 
+  uint64_t file_number_ = 0;
+  std::shared_ptr<BlockCache> cache_;  // 为空表示不缓存，每次都从 mmap 解析
+
   Footer footer_;                          // 存放在末尾读到的罗盘信息
   std::vector<IndexEntry> index_entries_;  // 内存中的索引“地图”
   std::string filter_data_;                // 存放从文件中读取的位图数据
@@ -2,105 +2,226 @@
 #ifndef SKIPLIST_H
 #define SKIPLIST_H
 
+#include <algorithm>
 #include <atomic>
 #include <iostream>
-#include <random>
+#include <memory>
+#include <new>
 #include <sstream>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include "Arena.h"
+#include "Random.h"
+
+namespace skiplist_detail {
+// 非字符串 key 不需要前缀，空基类不占节点空间
+template <bool kCache>
+struct KeyPrefix {
+  void set_prefix(uint64_t) {}
+};
+
+template <>
+struct KeyPrefix<true> {
+  void set_prefix(const uint64_t p) { prefix = p; }
+  // key 前 8 字节按大端拼成的整数，不足 8 字节补 0
+  uint64_t prefix = 0;
+};
+}  // namespace skiplist_detail
+
 template <typename K, typename V>
 class SkipList {
  public:
-  struct Node {
+  // 字符串类 key（std::string / std::string_view）在节点里缓存 8 字节前缀：
+  // 大端补零后整数大小关系和字典序一致，绝大多数比较只需一次整数比较，
+  // 不用去加载 key 字节本身（那是 Arena 里的另一条 cache line）
+  static constexpr bool kStringKey =
+      std::is_convertible_v<const K&, std::string_view>;
+
+  // 塔高的硬上限，查找路径用定长数组暂存，插入时不再堆分配 update 数组
+  static constexpr int kMaxLevelLimit = 32;
+
+  // V 足够小且可平凡拷贝时（MemTable 里就是一个指针）用 atomic 存放，
+  // 覆盖写可以和无锁读并发进行；否则退化成普通成员，只能在单线程下覆盖
+  static constexpr bool kAtomicValue =
+      std::is_trivially_copyable_v<V> && sizeof(V) <= sizeof(void*);
+  using ValueSlot = std::conditional_t<kAtomicValue, std::atomic<V>, V>;
+
+  struct Node : skiplist_detail::KeyPrefix<kStringKey> {
     K key;
-    V value;
+    ValueSlot value;
     // 存储每一层后继结点的指针数组
-    // std::vector<Node*> next;
-    // 用atomic改造next
-    std::vector<std::atomic<Node*>> next;
+    // 塔高不固定：next[0] 之后的 level - 1 个指针紧跟在结构体尾部，
+    // 和节点本身一起从 Arena 里一次分配出来，不再单独 new 一个 vector
+    std::atomic<Node*> next[1];
 
-    Node(K k, V v, int level) : key(k), value(v), next(level) {
+    Node(const K& k, V&& v) : key(k), value(std::move(v)) {
+      this->set_prefix(prefix_of(k));
       // atomic不可拷贝，因此不能全初始化为nullptr
-      for (int i = 0; i < level; i++) {
-        next[i].store(nullptr);  // 只能用store
-      }
+      next[0].store(nullptr);  // 只能用store
     }
   };
 
  private:
   int max_level;                   // 跳表允许的最大层高
   std::atomic<int> current_level;  // 当前跳表的实际最高层高
-  Node* head;                      // 头节点（哨兵）
-  std::atomic<int> node_count;     // 元素个数
+  std::unique_ptr<Arena> owned_arena_;  // 外部没传 Arena 时自己持有一个
+  Arena* arena_;                        // 节点内存都从这里分配
+  Node* head;                           // 头节点（哨兵）
+  std::atomic<int> node_count;          // 元素个数
+  // 插入手指：finger_[i] 是最近一次插入时第 i 层上落下的节点。
+  // 顺序（追加式）写入时新 key 的前驱就是它，插入可以跳过自顶向下的查找
+  std::atomic<Node*> finger_[kMaxLevelLimit];
 
  public:
-  SkipList(int max_level = 16)
-      : max_level(max_level), current_level(0), node_count(0) {
-    head = new Node(K(), V(), max_level);
+  // arena 由调用方（MemTable）持有时，节点内存随 arena 整体释放；
+  // 不传则跳表自己持有一个，生命周期与跳表相同
+  explicit SkipList(int max_level = 16, Arena* arena = nullptr)
+      : max_level(std::clamp(max_level, 1, kMaxLevelLimit)),
+        current_level(0),
+        owned_arena_(arena == nullptr ? std::make_unique<Arena>() : nullptr),
+        arena_(arena == nullptr ? owned_arena_.get() : arena),
+        node_count(0) {
+    head = create_node(K(), V(), this->max_level);
+    reset_finger();
   }
   ~SkipList() {
-    // 跳表有很多层，但我们不需要每一层都去删，因为所有层级的指针指向的其实是同一个
-    // Node 对象。 我们只需要沿着最底层的“主干道”（即
-    // next[0]）把所有楼拆了就行。
-    Node* curr = head->next[0];  // 从第 0 层的第一个有效节点开始
-    while (curr) {
-      Node* next_node = curr->next[0].load();  // 1. 先记住下一个人的地址
-      delete curr;                             // 2. 放心大胆地把当前节点拆了
-      curr = next_node;                        // 3. 挪到下一个人那里
+    // 节点内存归 Arena 管，这里不 delete，只负责调用 K/V 的析构函数。
+    // 对 MemTable 用的 string_view / 指针这类平凡类型，整个循环会被编译期跳过，
+    // 析构成本只剩 Arena 释放那几个大块。
+    if constexpr (!std::is_trivially_destructible_v<Node>) {
+      Node* curr = head->next[0];  // 从第 0 层的第一个有效节点开始
+      while (curr) {
+        Node* next_node = curr->next[0].load();  // 1. 先记住下一个人的地址
+        curr->~Node();                           // 2. 析构当前节点
+        curr = next_node;                        // 3. 挪到下一个人那里
+      }
+      head->~Node();  // 最后把那个一直带路的“哨兵楼”也析构掉
     }
-    delete head;  // 最后把那个一直带路的“哨兵楼”也拆了
   }
+
+  SkipList(const SkipList&) = delete;
+  SkipList& operator=(const SkipList&) = delete;
+
+  // 节点内存全部在 Arena 上，用它统计跳表真实占用
+  size_t MemoryUsage() const { return arena_->MemoryUsage(); }
   // 1. 核心增删改查
-  bool insert_element(K key, V value) {
-    Node* curr = head;
-    std::vector<Node*> update(max_level, head);
+  // 无锁并发插入：多个写线程可以同时调用，读线程全程不加锁
+  // key 已存在时直接覆盖 value
+  // value 按值传入再 move 进节点：传右值时整条路径没有拷贝
+  bool insert_element(const K& key, V value) {
+    insert_node(key, std::move(value),
+                [](const V&, const V&) { return true; });
+    return true;
+  }
 
-    // 1. 寻找每一层的前驱
-    for (int i = current_level - 1; i >= 0; i--) {
-      while (curr->next[i] && curr->next[i].load()->key < key) {
-        curr = curr->next[i];
+  // should_replace(old_value, new_value)：key 已存在时由调用方决定是否覆盖，
+  // MemTable 用它保证“同一个 key 并发写时，后写 WAL 的那条最终生效”
+  template <typename Replace>
+  bool insert_element(const K& key, V value, Replace should_replace) {
+    insert_node(key, std::move(value), should_replace);
+    return true;
+  }
+
+  // 同上，但返回承载这个 key 的节点（新建的，或者已存在被覆盖的那个），
+  // 节点地址在跳表生命周期内不变，可以交给外部索引长期持有
+  template <typename Replace>
+  Node* insert_node(const K& key, V value, Replace should_replace) {
+    const uint64_t prefix = prefix_of(key);
+    Node* prev[kMaxLevelLimit];
+    Node* next[kMaxLevelLimit];
+
+    // 1. 先定随机层数，并用 CAS 抬高 current_level
+    //    读线程看到“层数已抬高但 head 在这一层还是空”也没关系，会直接下降
+    const int level = get_random_level();
+    int list_level = current_level.load(std::memory_order_relaxed);
+    while (level > list_level &&
+           !current_level.compare_exchange_weak(list_level, level,
+                                                std::memory_order_relaxed)) {
+    }
+    const int top = std::max(level, list_level);
+
+    // 2. 寻找每一层的前驱 prev[i] 和后继 next[i]
+    //    只有 [0, level) 层需要挂链。如果手指在第 level-1 层恰好就是 key 的前驱
+    //    （顺序写入的常态），直接从那里往下走，不用从最高层的 head 开始
+    Node* before = head;
+    int start = top;
+    Node* hint = finger_[level - 1].load(std::memory_order_acquire);
+    if (is_before(hint, key, prefix)) {
+      Node* hint_next = hint->next[level - 1].load(std::memory_order_acquire);
+      if (hint_next == nullptr || !key_less(hint_next, key, prefix)) {
+        before = hint;
+        start = level;
       }
-      update[i] = curr;
+    }
+    for (int i = start - 1; i >= 0; i--) {
+      // 取“上一层找到的前驱”和“这一层的手指”里更靠右的那个作为起点
+      if (i < level - 1) {
+        Node* f = finger_[i].load(std::memory_order_acquire);
+        if (f != head && is_before(f, key, prefix) &&
+            (before == head || node_less(before, f))) {
+          before = f;
+        }
+      }
+      find_splice_for_level(key, prefix, before, i, &prev[i], &next[i]);
+      before = prev[i];
     }
 
-    curr = curr->next[0];
-    // 2. 重复性检查
-    if (curr && curr->key == key) {
-      curr->value = value;  // 示例：直接覆盖
-      return true;
+    // 3. 重复性检查
+    if (next[0] && key_equal(next[0], key, prefix)) {
+      update_value(next[0], std::move(value), should_replace);
+      return next[0];
     }
 
-    // 3. 处理随机层数
-    int level = get_random_level();
-    if (level > current_level) {
-      for (int i = current_level; i < level; i++) {
-        update[i] = head;
+    // 4. 创建节点，从第 0 层往上逐层 CAS 挂链
+    //    先挂第 0 层：只要第 0 层挂上了，节点就对读线程可见，高层只是加速索引
+    Node* new_node = create_node(key, std::move(value), level);
+    for (int i = 0; i < level; i++) {
+      while (true) {
+        new_node->next[i].store(next[i], std::memory_order_relaxed);
+        // release：保证读线程拿到 new_node 时，key/value/next 都已写好
+        if (prev[i]->next[i].compare_exchange_strong(
+                next[i], new_node, std::memory_order_release,
+                std::memory_order_relaxed)) {
+          break;
+        }
+        // CAS 失败说明有别的线程插在了 prev[i] 和 next[i] 之间，
+        // 从 prev[i] 继续往右重新定位这一层
+        find_splice_for_level(key, prefix, prev[i], i, &prev[i], &next[i]);
+        if (i == 0 && next[0] && key_equal(next[0], key, prefix)) {
+          // 同一个 key 被别的线程抢先插入：放弃自己的节点（内存留在 Arena），
+          // 退化成对已有节点的覆盖。value 已经 move 进了 new_node，从那里取回
+          V mine = take_value(new_node);
+          if constexpr (!std::is_trivially_destructible_v<Node>) {
+            new_node->~Node();
+          }
+          update_value(next[0], std::move(mine), should_replace);
+          return next[0];
+        }
       }
-      current_level = level;
     }
 
-    // 4. 创建并插入
-    Node* new_node = create_node(key, value, level);
+    // 新节点在 [0, level) 层都已挂好，作为下一次插入的手指
     for (int i = 0; i < level; i++) {
-      // new_node->next[i] = update[i]->next[i];
-      // update[i]->next[i] = new_node;
-      // 改成load和store
-      new_node->next[i].store(update[i]->next[i].load());
-      update[i]->next[i].store(new_node);
+      finger_[i].store(new_node, std::memory_order_release);
     }
-
-    ++node_count;
-    return true;
+    node_count.fetch_add(1, std::memory_order_relaxed);
+    return new_node;
   }
-  bool search_element(K key, V& value) const {
+  bool search_element(const K& key, V& value) const {
+    const uint64_t prefix = prefix_of(key);
     // 1. 从 head 开始，从当前最高层 (current_level - 1) 往下找
     Node* curr = head;
-    for (int i = current_level - 1; i >= 0; i--) {
-      Node* next_node = curr->next[i].load();  // 原子加载
+    for (int i = current_level.load(std::memory_order_relaxed) - 1; i >= 0;
+         i--) {
+      // 原子加载，acquire 与插入端的 release 配对
+      Node* next_node = curr->next[i].load(std::memory_order_acquire);
       // 2. 在每一层中，只要“下一个节点的 key”小于“目标 key”，就一直向右走
-      while (next_node && next_node->key < key) {
+      while (next_node && key_less(next_node, key, prefix)) {
         curr = next_node;
-        next_node = curr->next[i].load();
+        next_node = curr->next[i].load(std::memory_order_acquire);
       }
       // 3. 如果当前层走不动了（下一节点大于目标或为空），就下降一层
       // 4. 重复上述过程，直到降到第 0 层
@@ -109,14 +230,17 @@ class SkipList {
     // 5. 检查第 0 层的下一个节点：
     //    - 如果 key 相等，把 value 存入参数并返回 true
     //    - 否则，说明 key 不存在，返回 false
-    if (curr->next[0] && curr->next[0].load()->key == key) {
-      value = curr->next[0].load()->value;
+    Node* target = curr->next[0].load(std::memory_order_acquire);
+    if (target && key_equal(target, key, prefix)) {
+      value = load_value(target);
       return true;
     } else {
       return false;
     }
   }
-  bool delete_element(K key) {
+  // 注意：删除会析构节点，只能在没有并发读写时使用（MemTable 用 tombstone，
+  // 不走这条路径）
+  bool delete_element(const K& key) {
     // 1. 同样定义 update[max_level] 数组，记录每一层目标节点的前驱
     std::vector<Node*> update(max_level, head);
     // 2. 从最高层开始向下寻找，填充 update 数组
@@ -143,8 +267,10 @@ class SkipList {
         // 关键动作：跳过去
         update[i]->next[i].store(del_node->next[i].load());
       }
-      // 删除结点
-      delete del_node;
+      // 删除结点：内存留在 Arena 里随整体释放，这里只析构
+      // 手指可能还指着它，统一退回 head
+      reset_finger();
+      del_node->~Node();
       --node_count;
     } else {
       return false;
@@ -160,6 +286,11 @@ class SkipList {
 
   // 2. 辅助功能
   int size() const { return node_count; }
+
+  // 读取节点当前的 value（原子 value 用 acquire），供持有 Node* 的外部索引使用
+  static decltype(auto) node_value(const Node* node) {
+    return load_value(node);
+  }
   void display_list() {
     // 1. 获取基准 key（逻辑不变）
     std::vector<K> keys;
@@ -197,56 +328,187 @@ class SkipList {
   class Iterator {
    public:
     // 初始化迭代器指向某个节点
-    explicit Iterator(Node* node) : current_(node) {}
+    Iterator(const SkipList* list, Node* node) : list_(list), current_(node) {}
 
     // 1. 获取 Key
     const K& key() const { return current_->key; }
 
     // 2. 获取 Value
-    const V& value() const { return current_->value; }
+    decltype(auto) value() const { return load_value(current_); }
 
     // 3. 移动到下一个节点 (Level 0)
     void Next() {
       if (current_) {
         // 因为 next 是 atomic，所以要 load
-        current_ = current_->next[0].load();
+        current_ = current_->next[0].load(std::memory_order_acquire);
       }
     }
 
     // 4. 判断是否还有效
     bool Valid() const { return current_ != nullptr; }
 
+    // 5. 定位到第一个 key >= target 的节点：沿塔自顶向下跳，O(log n)
+    void Seek(const K& target) {
+      current_ = list_->find_greater_or_equal(target);
+    }
+
    private:
+    const SkipList* list_;
     Node* current_;
   };
 
   // --- 获取迭代器的接口 ---
   Iterator begin() {
     // 返回第 0 层的第一个有效节点
-    return Iterator(head->next[0].load());
+    return Iterator(this, head->next[0].load(std::memory_order_acquire));
   }
 
   Iterator begin() const {
     // 返回第 0 层的第一个有效节点
-    return Iterator(head->next[0].load());
+    return Iterator(this, head->next[0].load(std::memory_order_acquire));
+  }
+
+  // 返回指向第一个 key >= target 的迭代器，没有则无效
+  Iterator lower_bound(const K& target) const {
+    return Iterator(this, find_greater_or_equal(target));
   }
 
  private:
-  static Node* create_node(K k, V v, int level) {
-    return new Node(k, v, level);
+  // 原子 value 用 acquire 读；非原子 value 直接返回引用，避免拷贝
+  static decltype(auto) load_value(const Node* node) {
+    if constexpr (kAtomicValue) {
+      return node->value.load(std::memory_order_acquire);
+    } else {
+      return static_cast<const V&>(node->value);
+    }
   }
 
-  int get_random_level() const {
-    // 静态变量确保生成器只初始化一次，提升性能并保证随机性
-    static std::mt19937 gen(std::random_device{}());
-    static std::uniform_real_distribution<float> dis(0.0f, 1.0f);
+  Node* find_greater_or_equal(const K& key) const {
+    const uint64_t prefix = prefix_of(key);
+    Node* curr = head;
+    for (int i = current_level.load(std::memory_order_relaxed) - 1; i >= 0;
+         i--) {
+      Node* next_node = curr->next[i].load(std::memory_order_acquire);
+      while (next_node && key_less(next_node, key, prefix)) {
+        curr = next_node;
+        next_node = curr->next[i].load(std::memory_order_acquire);
+      }
+    }
+    return curr->next[0].load(std::memory_order_acquire);
+  }
 
-    int level = 1;
-    while (dis(gen) < 0.5f && level < max_level) {
-      level++;
+  // 从还没挂上链的节点里取回 value
+  static V take_value(Node* node) {
+    if constexpr (kAtomicValue) {
+      return node->value.load(std::memory_order_relaxed);
+    } else {
+      return std::move(node->value);
     }
-    return level;
+  }
+
+  template <typename Replace>
+  static void update_value(Node* node, V value, Replace& should_replace) {
+    if constexpr (kAtomicValue) {
+      V expected = node->value.load(std::memory_order_acquire);
+      while (should_replace(expected, value) &&
+             !node->value.compare_exchange_weak(expected, value,
+                                                std::memory_order_release,
+                                                std::memory_order_acquire)) {
+      }
+    } else {
+      if (should_replace(node->value, value)) {
+        node->value = std::move(value);
+      }
+    }
+  }
+
+  static uint64_t prefix_of(const K& key) {
+    if constexpr (kStringKey) {
+      const std::string_view k(key);
+      const size_t n = k.size() < 8 ? k.size() : 8;
+      uint64_t prefix = 0;
+      for (size_t i = 0; i < n; ++i) {
+        prefix |= static_cast<uint64_t>(static_cast<unsigned char>(k[i]))
+                  << (56 - 8 * i);
+      }
+      return prefix;
+    } else {
+      return 0;
+    }
+  }
+
+  void reset_finger() {
+    for (auto& f : finger_) {
+      f.store(head, std::memory_order_relaxed);
+    }
+  }
+
+  // node 排在 key 之前（head 排在所有 key 之前）
+  bool is_before(const Node* node, const K& key, const uint64_t prefix) const {
+    return node == head || key_less(node, key, prefix);
+  }
+
+  // 两个非 head 节点之间的比较
+  static bool node_less(const Node* a, const Node* b) {
+    if constexpr (kStringKey) {
+      return key_less(a, b->key, b->prefix);
+    } else {
+      return a->key < b->key;
+    }
+  }
+
+  // node->key < key；前缀不同就能直接出结果，相同才回退到完整比较
+  static bool key_less(const Node* node, const K& key, const uint64_t prefix) {
+    if constexpr (kStringKey) {
+      if (node->prefix != prefix) {
+        return node->prefix < prefix;
+      }
+    }
+    return node->key < key;
+  }
+
+  static bool key_equal(const Node* node, const K& key,
+                        const uint64_t prefix) {
+    if constexpr (kStringKey) {
+      if (node->prefix != prefix) {
+        return false;
+      }
+    }
+    return node->key == key;
+  }
+
+  // 从 before 出发在第 level 层向右走，找到 key 的前驱和后继
+  void find_splice_for_level(const K& key, const uint64_t prefix, Node* before,
+                             int level, Node** out_prev,
+                             Node** out_next) const {
+    Node* curr = before;
+    while (true) {
+      Node* next_node = curr->next[level].load(std::memory_order_acquire);
+      if (next_node == nullptr || !key_less(next_node, key, prefix)) {
+        *out_prev = curr;
+        *out_next = next_node;
+        return;
+      }
+      curr = next_node;
+    }
+  }
+
+  Node* create_node(const K& k, V v, int level) {
+    // 节点 + 塔高为 level 的 next 数组一次性从 Arena 分配
+    char* mem = arena_->AllocateAligned(
+        sizeof(Node) + sizeof(std::atomic<Node*>) * (level - 1));
+    Node* node = new (mem) Node(k, std::move(v));
+    for (int i = 1; i < level; i++) {
+      new (&node->next[i]) std::atomic<Node*>(nullptr);
+    }
+    return node;
+  }
+
+  int get_random_level() const {
+    // 每个写线程各持有一份 xorshift 生成器，并发插入时不共享状态；
+    // 按 1/2 概率逐层晋升，和原来逐次抛硬币的分布相同
+    return Random::ThreadLocal().NextHeight(max_level);
   }
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -0,0 +1,26 @@
+//
+// Created by 26708 on 2026/3/24.
+//
+
+#ifndef NOVAKV_SNAPSHOT_H
+#define NOVAKV_SNAPSHOT_H
+
+#include "ValueRecord.h"
+
+// DB 在某一时刻的只读视图，本质上就是一个序号：
+// 按快照读只看序号 <= sequence() 的版本。由 DBImpl::GetSnapshot 创建，
+// 用完必须交还 DBImpl::ReleaseSnapshot，否则 Compaction 会一直保留它需要的旧版本
+class Snapshot {
+ public:
+  SequenceNumber sequence() const { return sequence_; }
+
+ private:
+  friend class DBImpl;
+
+  explicit Snapshot(const SequenceNumber sequence) : sequence_(sequence) {}
+  ~Snapshot() = default;
+
+  const SequenceNumber sequence_;
+};
+
+#endif  // NOVAKV_SNAPSHOT_H
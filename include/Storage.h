@@ -18,6 +18,17 @@ struct BlockHandle {
   BlockHandle() : offset(0), size(0) {}
 };
 
+// 数据块和索引块的编码格式，由 Footer 的魔数决定
+enum class BlockFormat {
+  // 记录是 [KeyLen (4B)][Key][ValueType (1B)][ValueLen (4B)][Value]，
+  // 没有重启点，只能从头扫
+  kPlain,
+  // 记录同 kPlain，块尾带重启点数组
+  kRestarts,
+  // key 按前缀压缩、长度用 varint，块尾带重启点数组
+  kPrefixCompressed,
+};
+
 // 索引项：这块地盘最大的 Key 是谁，在哪能找到它
 struct IndexEntry {
   std::string last_key;
@@ -28,14 +39,34 @@ struct IndexEntry {
 // Index Handle：记录 Index Block 的 offset(8字节) 和 size(8字节)。
 // Magic Number：一个 8 字节的随机数（魔数），用来确认这到底是不是一个 NovaKV
 // 的存储文件。
+// 旧格式：[Index][Filter][Magic]，数据块里的 key 就是用户 key。
+// 带序号的格式：[Index][Filter][MaxSequence (8B)][MagicV2]，数据块里的 key
+// 是 [UserKey][Sequence (8B)]，同一个 key 的多个版本按序号从新到旧相邻存放；
+// 索引和布隆过滤器仍然只用用户 key。
+// MagicV3 的 Footer 和 V2 一样长，区别是数据块和索引块末尾带重启点数组；
+// MagicV4 在此基础上把块里的 key 换成前缀压缩编码
 struct Footer {
   inline static const uint64_t kMagicNumber =
       0xDEADC0DEFA112026;  // 你的专属魔数
-  inline static const size_t kEncodedLength =
+  inline static const uint64_t kSequencedMagicNumber = 0xDEADC0DEFA112027;
+  inline static const uint64_t kRestartMagicNumber = 0xDEADC0DEFA112028;
+  inline static const uint64_t kPrefixMagicNumber = 0xDEADC0DEFA112029;
+  inline static const size_t kLegacyEncodedLength =
       16 + 16 + 8;  // 2个uint64 + 1个magic
+  inline static const size_t kEncodedLength = kLegacyEncodedLength + 8;
 
   BlockHandle index_handle;
   BlockHandle filter_handle;
+  // 文件里最大的序号，旧格式为 0
+  uint64_t max_sequence = 0;
+  // 数据块里的 key 是否带序号后缀
+  bool sequenced = true;
+  // 数据块和索引块的编码格式
+  BlockFormat block_format = BlockFormat::kPrefixCompressed;
+
+  size_t EncodedLength() const {
+    return sequenced ? kEncodedLength : kLegacyEncodedLength;
+  }
 
   // 序列化：结构体 -> 字节流
   void EncodeTo(std::string* dst) const {
@@ -53,26 +84,52 @@ struct Footer {
     dst->append(reinterpret_cast<const char*>(&filter_handle.size),
                 sizeof(uint64_t));
 
+    // 8 字节的最大序号
+    dst->append(reinterpret_cast<const char*>(&max_sequence), sizeof(uint64_t));
+
     // 8 字节的 MagicNumber
-    dst->append(reinterpret_cast<const char*>(&kMagicNumber), sizeof(uint64_t));
+    dst->append(reinterpret_cast<const char*>(&kPrefixMagicNumber),
+                sizeof(uint64_t));
   }
 
-  // 反序列化：字节流 -> 结构体
+  // 反序列化：字节流 -> 结构体。input 是文件末尾的至多 kEncodedLength 字节，
+  // 按最后 8 字节的魔数区分四种格式
   bool DecodeFrom(const std::string& input) {
-    if (input.size() < kEncodedLength) return false;
+    if (input.size() < kLegacyEncodedLength) return false;
 
-    const char* p = input.data();
+    uint64_t magic;
+    std::memcpy(&magic, input.data() + input.size() - 8, sizeof(uint64_t));
+    if (magic == kPrefixMagicNumber || magic == kRestartMagicNumber ||
+        magic == kSequencedMagicNumber) {
+      if (input.size() < kEncodedLength) return false;
+      sequenced = true;
+      if (magic == kPrefixMagicNumber) {
+        block_format = BlockFormat::kPrefixCompressed;
+      } else if (magic == kRestartMagicNumber) {
+        block_format = BlockFormat::kRestarts;
+      } else {
+        block_format = BlockFormat::kPlain;
+      }
+    } else if (magic == kMagicNumber) {
+      sequenced = false;
+      block_format = BlockFormat::kPlain;
+      max_sequence = 0;
+    } else {
+      return false;  // 校验魔数
+    }
+
+    const char* p = input.data() + input.size() - EncodedLength();
     std::memcpy(&index_handle.offset, p, sizeof(uint64_t));
     std::memcpy(&index_handle.size, p + 8, sizeof(uint64_t));
 
     std::memcpy(&filter_handle.offset, p + 16, 8);
     std::memcpy(&filter_handle.size, p + 24, 8);
 
-    uint64_t magic;
-    std::memcpy(&magic, p + 32, sizeof(uint64_t));
-
-    return (magic == kMagicNumber);  // 校验魔数
+    if (sequenced) {
+      std::memcpy(&max_sequence, p + 32, sizeof(uint64_t));
+    }
+    return true;
   }
 };
 
-#endif  // NOVAKV_STORAGE_H
\ No newline at end of file
+#endif  // NOVAKV_STORAGE_H
\ No newline at end of file
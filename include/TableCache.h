@@ -0,0 +1,80 @@
+//
+// Created by 26708 on 2026/3/29.
+//
+// 由 DB 持有的 SST 打开缓存：levels_ 里只登记文件的元数据，读的时候才经由
+// TableCache 打开 SSTableReader（mmap、读索引和布隆过滤器），打开的文件数
+// 超过 max_open_files 时关掉最久没用的那个。启动时只读每个文件的 Footer，
+// 文件描述符和常驻的索引内存都不再随 SST 的个数增长。
+// 取出的 reader 是 shared_ptr，被淘汰时正在用它的读者不受影响。
+
+#ifndef NOVAKV_TABLECACHE_H
+#define NOVAKV_TABLECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "BlockCache.h"
+#include "SSTableReader.h"
+
+// levels_ 里登记的一个 SST：不用打开它就能知道的信息
+struct FileMetaData {
+  uint64_t number = 0;
+  uint64_t file_size = 0;
+  // 文件里最大的序号，旧格式文件为 0
+  SequenceNumber max_sequence = 0;
+};
+
+class TableCache {
+ public:
+  // max_open_files 至少为 1；block_cache 为空表示不用块缓存
+  TableCache(std::string db_path, size_t max_open_files,
+             std::shared_ptr<BlockCache> block_cache);
+
+  TableCache(const TableCache&) = delete;
+  TableCache& operator=(const TableCache&) = delete;
+
+  std::string TablePath(uint64_t file_number) const;
+
+  // 只读 Footer 得到文件的元数据，不打开 reader
+  bool ReadMetaData(uint64_t file_number, FileMetaData* meta) const;
+
+  // 打开一个不进缓存的 reader，刚写完的 SST 用它校验，失败返回 nullptr
+  SSTableReader* Open(uint64_t file_number) const;
+
+  // 命中时挪到 LRU 的最新端；未命中就现在打开，打开失败返回 nullptr
+  std::shared_ptr<SSTableReader> Get(uint64_t file_number);
+
+  // 刚写完、已经打开校验过的 SST 直接放进缓存（接管 reader），
+  // 返回要登记到 levels_ 的元数据
+  FileMetaData Insert(uint64_t file_number, SSTableReader* reader);
+
+  // 文件被删除时调用：从缓存里摘掉，它的块也从块缓存里清掉
+  void Evict(uint64_t file_number);
+
+  // 当前打开着的 reader 个数
+  size_t OpenFiles() const;
+
+ private:
+  using Entry = std::pair<uint64_t, std::shared_ptr<SSTableReader>>;
+
+  // 调用方持有 mu_：放进一个 reader，超出容量时从最旧的一端淘汰
+  void InsertLocked(uint64_t file_number,
+                    std::shared_ptr<SSTableReader> reader);
+
+  const std::string db_path_;
+  const size_t capacity_;
+  const std::shared_ptr<BlockCache> block_cache_;
+
+  mutable std::mutex mu_;
+  // 队头最新、队尾最旧
+  std::list<Entry> lru_;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
+
+#endif  // NOVAKV_TABLECACHE_H
@@ -10,9 +10,16 @@
 
 enum class ValueType : uint8_t { kValue = 1, kDeletion = 2 };
 
+// 全局写入序号：每条写入（WriteBatch 里每条记录）占一个，越大越新。
+// 只用低 56 位；0 表示没有序号的旧数据（旧格式 SST / WAL），比所有新写入都旧
+using SequenceNumber = uint64_t;
+inline constexpr SequenceNumber kMaxSequenceNumber = (1ULL << 56) - 1;
+
 struct ValueRecord {
   ValueType type;
   std::string value;
+  // 这个版本的写入序号，只在需要区分多版本的路径上填写
+  SequenceNumber sequence = 0;
 };
 
 #endif  // NOVAKV_VALUERECORD_H
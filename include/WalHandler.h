@@ -5,33 +5,176 @@
 #ifndef NOVAKV_WALHANDLER_H
 #define NOVAKV_WALHANDLER_H
 
+#include <atomic>
 #include <cstdint>
-#include <fstream>
 #include <functional>
 #include <string>
 
+#include "Options.h"
 #include "ValueRecord.h"
 
+// 打开 WAL 用于写入时的选项，只回放的话用默认值即可
+struct WalOpenOptions {
+  // 非 0 时新文件使用可复用格式，把这个编号写进文件头和每个物理记录
+  uint64_t log_number = 0;
+  // 复用一个旧 WAL 文件：从头原地覆盖，不截断也不追加。
+  // 需要同时给出 log_number，回放时凭它区分本轮写入和上一轮的残留
+  bool recycle = false;
+  // 打开时用 fallocate 预留的磁盘空间（不改变文件长度），0 表示不预留
+  size_t preallocate_bytes = 0;
+};
+
 class WalHandler {
+ public:
+  // 回放回调：sequence 为 0 表示记录没有序号（旧格式或 AddLog 写入），
+  // 由调用方接着分配
+  using SequencedCallback =
+      std::function<void(SequenceNumber, ValueType, const std::string&,
+                         const std::string&)>;
+
  private:
-  std::ofstream dest_;  // 文件输出流
+  int fd_ = -1;  // 直接 write + fdatasync 的文件描述符，新文件以 O_APPEND 打开
   std::string filename_;
 
-  // 预计算的 CRC32 表，用于加速计算
-  uint32_t CalculateCRC32(const char* data, size_t len);
+  WalSyncMode sync_mode_ = WalSyncMode::kNone;
+  size_t bytes_per_sync_ = 0;
+  // 已经 write 但还没 fdatasync 的字节数
+  std::atomic<size_t> unsynced_bytes_{0};
+  // 成功的 fdatasync 次数
+  std::atomic<uint64_t> sync_count_{0};
+  // write 或 fdatasync 失败过：文件尾可能是半条记录，block_offset_ 也已经
+  // 和文件对不上，之后的记录回放时读不到，所以不再接受任何写入
+  std::atomic<bool> failed_{false};
+
+  // 把整个缓冲区写进 fd，处理 EINTR 和短写
+  bool WriteAll(const char* data, size_t len);
+  // 失败时把 WAL 标记为不可用
+  bool DataSync();
+  void Preallocate(size_t bytes);
+
+  // 旧格式（没有文件头）WAL 用的 CRC32，只为回放老文件保留
+  static uint32_t CalculateCRC32(const char* data, size_t len);
+
+  // 这个文件的格式版本。新文件用带序号的分块格式；往旧文件后面追加时
+  // 沿用旧格式，同一个文件里不混用两种格式
+  int version_ = kVersionSequenced;
+  // 新文件的文件头推迟到第一次写入时再写，只读打开的空文件保持为空
+  bool header_pending_ = false;
+  // 分块格式下，下一个字节在当前块内的偏移
+  size_t block_offset_ = 0;
+  // 可复用格式下本文件的编号
+  uint64_t log_number_ = 0;
+
+  static bool IsRecyclable(const int version) {
+    return version == kVersionRecyclable ||
+           version == kVersionRecyclableSequenced;
+  }
+  bool Recyclable() const { return IsRecyclable(version_); }
+  bool Sequenced() const { return version_ >= kVersionSequenced; }
+  size_t FileHeaderSize() const {
+    return Recyclable() ? kRecyclableHeaderSize : kHeaderSize;
+  }
+  size_t FragmentHeaderSize() const {
+    return Recyclable() ? kRecyclableFragmentHeaderSize : kFragmentHeaderSize;
+  }
+
+  // 把一条逻辑记录切成若干物理记录追加到 dst，块尾放不下头部时补零
+  void AppendFragments(std::string* dst, const char* data, size_t len);
+
+  // 回放没有分块的旧格式（版本 0/1）：[CRC][Payload] 首尾相接
+  void LoadUnframedLog(std::ifstream& src, bool use_crc32c,
+                       const SequencedCallback& callback);
+  // 回放分块格式：整块批量读入，在缓冲区上原地校验、解析。
+  // expected_log 非 0 表示可复用格式，编号不符的物理记录视为文件结尾；
+  // sequenced 表示每条逻辑记录以起始序号开头
+  void LoadBlockLog(uint64_t expected_log, bool sequenced,
+                    const SequencedCallback& callback);
 
  public:
-  explicit WalHandler(const std::string& filename);
+  explicit WalHandler(const std::string& filename,
+                      const WalOpenOptions& options = WalOpenOptions());
   ~WalHandler();
   // 获取文件名
   std::string GetFilename() const;
 
-  // 核心接口：将 KV 操作持久化
-  void AddLog(const std::string& key, const std::string& value, ValueType type);
+  // 核心接口：将 KV 操作持久化，失败返回 false
+  bool AddLog(const std::string& key, const std::string& value, ValueType type);
+
+  // 文件格式：[Magic "NOVAWAL" (7B)][Version (1B)] + 若干条记录。
+  // 没有文件头的旧文件按 CRC32 回放
+  static constexpr char kMagic[] = "NOVAWAL";
+  static constexpr size_t kMagicSize = sizeof(kMagic) - 1;
+  static constexpr size_t kHeaderSize = kMagicSize + 1;
+  // 版本 1：记录校验和换成 CRC32C
+  static constexpr uint8_t kVersionCrc32c = 1;
+  // 版本 2：LevelDB 式分块格式。文件按 32KB 切块（文件头占第 0 块开头），
+  // 一条逻辑记录切成若干物理记录 [CRC32C (4B)][Length (2B)][Type (1B)][Data]，
+  // CRC 覆盖 Type 和 Data。块尾剩余不足 7 字节时补零，物理记录不跨块
+  static constexpr uint8_t kVersionBlock = 2;
+  static constexpr size_t kBlockSize = 32 * 1024;
+  static constexpr size_t kFragmentHeaderSize = 4 + 2 + 1;
+  // 版本 3：可复用的分块格式。文件头后面多一个 [LogNumber (8B)]，物理记录头
+  // 变成 [CRC32C (4B)][Length (2B)][Type (1B)][LogNumber (4B)]，CRC 覆盖
+  // Type、LogNumber 和 Data。复用的旧文件里上一轮留下的记录编号对不上，
+  // 回放读到那里就停
+  static constexpr uint8_t kVersionRecyclable = 3;
+  static constexpr size_t kRecyclableHeaderSize = kHeaderSize + 8;
+  static constexpr size_t kRecyclableFragmentHeaderSize =
+      kFragmentHeaderSize + 4;
+  // 版本 4 / 5：分别在版本 2 / 3 的基础上，给每条逻辑记录加一个
+  // [FirstSequence (8B)] 前缀，记录里的第 i 条 Payload 的序号是
+  // FirstSequence + i，回放后 MemTable 里的版本和崩溃前一致
+  static constexpr uint8_t kVersionSequenced = 4;
+  static constexpr uint8_t kVersionRecyclableSequenced = 5;
+  static constexpr size_t kSequenceHeaderSize = sizeof(SequenceNumber);
+  enum FragmentType : uint8_t {
+    kZeroType = 0,  // 块尾补零
+    kFullType = 1,
+    kFirstType = 2,
+    kMiddleType = 3,
+    kLastType = 4,
+  };
+
+  // 开始编码一条逻辑记录：带序号的格式先写下批内第一条的序号，
+  // 其他格式什么都不写。first_sequence 为 0 表示不指定，回放时再分配
+  void BeginBatch(std::string* dst, SequenceNumber first_sequence) const;
+
+  // 把一条 KV 操作编码后追加到 dst 末尾，不落盘。组提交时 leader 先
+  // BeginBatch，再把一批记录编码进同一个缓冲区，最后一次性 AddRecords。分块格式下只编码 Payload，
+  // 整批在 AddRecords 里作为一条逻辑记录分片、校验，回放时要么整批都在，
+  // 要么整批都不在；旧格式下每条记录自带 [CRC (4B)]
+  void EncodeRecord(std::string* dst, const std::string& key,
+                    const std::string& value, ValueType type) const;
+
+  // 写入一批已编码好的记录：一次 write。sync 为 true，或者同步策略
+  // 要求时（kEveryWrite / kPeriodic 攒够字节），返回前 fdatasync。
+  // 分块格式需要跟踪块内偏移，调用方保证同一时刻只有一个线程写入。
+  // write 或要求的 fdatasync 失败时返回 false，此后这个 WAL 拒绝一切写入
+  bool AddRecords(const std::string& encoded, bool sync = false);
+
+  // 在第一次写入之前设置同步策略
+  void SetSyncPolicy(WalSyncMode mode, size_t bytes_per_sync);
+
+  // 把已写入的数据 fdatasync 到磁盘，没有未同步的数据时直接返回 true。
+  // 可以和 AddRecords 并发调用（后台定时同步）。失败时同样把 WAL 标记为不可用
+  bool Sync();
+
+  // write 或 fdatasync 失败过，这个 WAL 已经不能再写
+  bool Failed() const { return failed_.load(std::memory_order_acquire); }
+
+  // 统计：这个 WAL 已经 fdatasync 过的次数和还没同步的字节数
+  uint64_t SyncCount() const {
+    return sync_count_.load(std::memory_order_relaxed);
+  }
+  size_t UnsyncedBytes() const {
+    return unsynced_bytes_.load(std::memory_order_relaxed);
+  }
 
   void LoadLog(
       std::function<void(ValueType, const std::string&, const std::string&)>
           callback);
+  // 同 LoadLog，额外给出每条记录的序号
+  void LoadLogWithSequence(const SequencedCallback& callback);
 };
 
 #endif  // NOVAKV_WALHANDLER_H
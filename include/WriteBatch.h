@@ -0,0 +1,51 @@
+//
+// Created by 26708 on 2026/3/22.
+//
+// 一组 Put/Delete 的原子写入：整批编码进同一条 WAL 逻辑记录，崩溃恢复时
+// 要么全部回放、要么一条都不回放；写进 MemTable 时读者也看不到半批。
+// 同一个 key 在批内出现多次时，后写的生效。
+
+#ifndef NOVAKV_WRITEBATCH_H
+#define NOVAKV_WRITEBATCH_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ValueRecord.h"
+
+class WriteBatch {
+ public:
+  using Entry = std::pair<std::string, ValueRecord>;
+
+  void Put(const std::string& key, const std::string& value) {
+    bytes_ += key.size() + value.size();
+    entries_.emplace_back(key, ValueRecord{ValueType::kValue, value});
+  }
+
+  // 和单条删除一样写 tombstone
+  void Delete(const std::string& key) {
+    bytes_ += key.size();
+    entries_.emplace_back(key, ValueRecord{ValueType::kDeletion, ""});
+  }
+
+  void Clear() {
+    entries_.clear();
+    bytes_ = 0;
+  }
+
+  size_t Count() const { return entries_.size(); }
+
+  // 所有 key 和 value 的字节数，用来估算 WAL 组提交的大小
+  size_t ApproximateSize() const { return bytes_; }
+
+  // 按写入顺序排列
+  const std::vector<Entry>& Entries() const { return entries_; }
+
+ private:
+  std::vector<Entry> entries_;
+  size_t bytes_ = 0;
+};
+
+#endif  // NOVAKV_WRITEBATCH_H
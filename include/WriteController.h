@@ -0,0 +1,53 @@
+//
+// Created by 26708 on 2026/3/25.
+//
+// 写入限速：后台落盘或 L0->L1 跟不上时，先按令牌桶把写入速率压下来，
+// 积压越重压得越低，超过硬上限才让写线程停下来等后台。
+// 比起等队列排满再一次性卡死，写入延迟是逐步变差的。
+
+#ifndef NOVAKV_WRITECONTROLLER_H
+#define NOVAKV_WRITECONTROLLER_H
+
+#include <cstdint>
+#include <mutex>
+
+enum class WriteStallCondition {
+  kNormal,   // 不限速
+  kDelayed,  // 按令牌桶限速
+  kStopped,  // 停写，等后台消化积压
+};
+
+class WriteController {
+ public:
+  // max_rate 是刚进入限速时允许的写入速率（字节/秒）
+  explicit WriteController(uint64_t max_rate);
+
+  // 由 DBImpl 在积压变化后调用。pressure 在 [0, 1] 之间，表示积压在
+  // 软、硬上限之间走到了哪里，越接近 1 速率越低，最低降到 max_rate 的 1/16
+  void SetCondition(WriteStallCondition condition, double pressure);
+
+  WriteStallCondition condition() const;
+  // 当前的限速速率（字节/秒），不限速时为 0
+  uint64_t delayed_write_rate() const;
+
+  // 写入 bytes 字节前应当等待的微秒数，只在 kDelayed 下可能非零。
+  // 令牌立即扣除（可以扣成负数），并发的写线程依次排在前一个后面
+  uint64_t GetDelay(uint64_t bytes);
+
+ private:
+  // 调用方持有 mu_：按流逝的时间补充令牌
+  void RefillLocked(uint64_t now_micros);
+
+  static uint64_t NowMicros();
+
+  const uint64_t max_rate_;
+
+  mutable std::mutex mu_;
+  WriteStallCondition condition_ = WriteStallCondition::kNormal;
+  uint64_t rate_ = 0;
+  // 桶里剩余的字节数，负数表示已经预支、后来的写入要先等它还清
+  double available_ = 0;
+  uint64_t last_refill_micros_ = 0;
+};
+
+#endif  // NOVAKV_WRITECONTROLLER_H
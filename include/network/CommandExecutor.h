@@ -23,11 +23,17 @@ class CommandExecutor {
                  NetworkBuffer* response_buffer) const;
   void HandleRScan(const std::vector<std::string>& command,
                    NetworkBuffer* response_buffer) const;
+  void HandleMSet(const std::vector<std::string>& command,
+                  NetworkBuffer* response_buffer) const;
+  void HandleMDel(const std::vector<std::string>& command,
+                  NetworkBuffer* response_buffer) const;
 
   static std::string NormalizeCommandName(const std::string& command_name);
   static bool ExpectArgCount(const std::vector<std::string>& command,
                              size_t expected_argc,
                              NetworkBuffer* response_buffer);
+  static void ReplyWrongArgCount(const std::vector<std::string>& command,
+                                 NetworkBuffer* response_buffer);
 
   DBImpl* db_;
 };
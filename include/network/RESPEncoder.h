@@ -5,6 +5,7 @@
 #ifndef NOVAKV_RESPENCODER_H
 #define NOVAKV_RESPENCODER_H
 #include <string>
+#include <string_view>
 
 #include "NetworkBuffer.h"
 
@@ -48,7 +49,7 @@ class RESPEncoder {
      确保二进制安全）。
         4. 写入结尾的 \r\n。
    */
-  static void EncodeBulkString(NetworkBuffer* buffer, const std::string& str);
+  static void EncodeBulkString(NetworkBuffer* buffer, std::string_view str);
 
   /*
       Null (空响应)
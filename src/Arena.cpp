@@ -0,0 +1,76 @@
+//
+// Created by 26708 on 2026/3/13.
+//
+
+#include "Arena.h"
+
+#include <cstdint>
+
+namespace {
+constexpr size_t kBlockSize = 4096;
+}  // namespace
+
+Arena::Arena()
+    : alloc_ptr_(nullptr), alloc_bytes_remaining_(0), memory_usage_(0) {}
+
+Arena::~Arena() {
+  for (const char* block : blocks_) {
+    delete[] block;
+  }
+}
+
+char* Arena::Allocate(const size_t bytes) {
+  std::lock_guard lock(mu_);
+  if (bytes <= alloc_bytes_remaining_) {
+    char* result = alloc_ptr_;
+    alloc_ptr_ += bytes;
+    alloc_bytes_remaining_ -= bytes;
+    return result;
+  }
+  return AllocateFallback(bytes);
+}
+
+char* Arena::AllocateAligned(const size_t bytes) {
+  constexpr size_t align = alignof(std::max_align_t) > sizeof(void*)
+                               ? alignof(std::max_align_t)
+                               : sizeof(void*);
+  static_assert((align & (align - 1)) == 0, "align must be a power of 2");
+
+  std::lock_guard lock(mu_);
+  const size_t current_mod =
+      reinterpret_cast<uintptr_t>(alloc_ptr_) & (align - 1);
+  const size_t slop = current_mod == 0 ? 0 : align - current_mod;
+  const size_t needed = bytes + slop;
+  if (needed <= alloc_bytes_remaining_) {
+    char* result = alloc_ptr_ + slop;
+    alloc_ptr_ += needed;
+    alloc_bytes_remaining_ -= needed;
+    return result;
+  }
+  // 新块由 new[] 分配，天然满足对齐要求
+  return AllocateFallback(bytes);
+}
+
+char* Arena::AllocateFallback(const size_t bytes) {
+  if (bytes > kBlockSize / 4) {
+    // 大对象（比如大 value）单独占一个块，避免浪费当前块剩余空间
+    return AllocateNewBlock(bytes);
+  }
+
+  // 当前块剩余的尾部直接丢弃
+  alloc_ptr_ = AllocateNewBlock(kBlockSize);
+  alloc_bytes_remaining_ = kBlockSize;
+
+  char* result = alloc_ptr_;
+  alloc_ptr_ += bytes;
+  alloc_bytes_remaining_ -= bytes;
+  return result;
+}
+
+char* Arena::AllocateNewBlock(const size_t block_bytes) {
+  char* result = new char[block_bytes];
+  blocks_.push_back(result);
+  memory_usage_.fetch_add(block_bytes + sizeof(char*),
+                          std::memory_order_relaxed);
+  return result;
+}
@@ -0,0 +1,197 @@
+//
+// Created by 26708 on 2026/3/26.
+//
+
+#include "Block.h"
+
+#include <cstring>
+
+#include "Coding.h"
+
+namespace {
+
+// 一条记录解出来的各个字段，key 只是和上一条不共享的那部分
+struct EntryHeader {
+  uint32_t shared = 0;
+  const char* key = nullptr;
+  uint32_t non_shared = 0;
+  ValueType type = ValueType::kValue;
+  const char* value = nullptr;
+  uint32_t value_len = 0;
+  const char* end = nullptr;  // 下一条记录的开头
+};
+
+// 解析 [p, limit) 开头的一条记录，数据不完整时返回 false。
+// kPlain/kRestarts：[KeyLen (4B)][Key][ValueType][ValLen (4B)][Value]
+// kPrefixCompressed：[Shared][NonShared][ValLen] 三个 varint，
+// 后面是 [ValueType][Key 的非共享部分][Value]
+bool DecodeEntry(const char* p, const char* limit, const BlockFormat format,
+                 EntryHeader* h) {
+  if (format == BlockFormat::kPrefixCompressed) {
+    if ((p = GetVarint32Ptr(p, limit, &h->shared)) == nullptr ||
+        (p = GetVarint32Ptr(p, limit, &h->non_shared)) == nullptr ||
+        (p = GetVarint32Ptr(p, limit, &h->value_len)) == nullptr) {
+      return false;
+    }
+    if (static_cast<uint64_t>(limit - p) <
+        uint64_t{1} + h->non_shared + h->value_len) {
+      return false;
+    }
+    h->type = static_cast<ValueType>(*p);
+    h->key = p + 1;
+    h->value = h->key + h->non_shared;
+  } else {
+    if (static_cast<size_t>(limit - p) < sizeof(uint32_t)) return false;
+    std::memcpy(&h->non_shared, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    if (static_cast<uint64_t>(limit - p) <
+        uint64_t{h->non_shared} + sizeof(uint8_t) + sizeof(uint32_t)) {
+      return false;
+    }
+    h->shared = 0;
+    h->key = p;
+    p += h->non_shared;
+    h->type = static_cast<ValueType>(*p);
+    p += sizeof(uint8_t);
+    std::memcpy(&h->value_len, p, sizeof(uint32_t));
+    p += sizeof(uint32_t);
+    if (static_cast<size_t>(limit - p) < h->value_len) return false;
+    h->value = p;
+  }
+  h->end = h->value + h->value_len;
+  return true;
+}
+
+}  // namespace
+
+Block::Block(const char* data, const size_t size, const bool sequenced,
+             const BlockFormat format) {
+  Init(data, size, sequenced, format);
+}
+
+std::shared_ptr<const Block> Block::Copy(const char* data, const size_t size,
+                                         const bool sequenced,
+                                         const BlockFormat format) {
+  std::shared_ptr<Block> block(new Block());
+  block->owned_.assign(data, size);
+  block->Init(block->owned_.data(), size, sequenced, format);
+  return block;
+}
+
+void Block::Init(const char* data, const size_t size, const bool sequenced,
+                 const BlockFormat format) {
+  data_ = data;
+  size_ = size;
+  sequenced_ = sequenced;
+  format_ = format;
+  if (format == BlockFormat::kPlain) {
+    return;
+  }
+  // 末尾 4 字节是重启点个数，前面是重启点数组；长度对不上按空块处理
+  uint32_t num_restarts = 0;
+  if (size >= sizeof(uint32_t)) {
+    std::memcpy(&num_restarts, data + size - sizeof(uint32_t),
+                sizeof(uint32_t));
+  }
+  const uint64_t trailer =
+      (static_cast<uint64_t>(num_restarts) + 1) * sizeof(uint32_t);
+  if (size < sizeof(uint32_t) || trailer > size) {
+    size_ = 0;
+    return;
+  }
+  size_ = size - trailer;
+  restarts_ = data + size_;
+  num_restarts_ = num_restarts;
+}
+
+uint32_t Block::RestartPoint(const uint32_t index) const {
+  uint32_t offset;
+  std::memcpy(&offset, restarts_ + index * sizeof(uint32_t), sizeof(uint32_t));
+  return offset;
+}
+
+bool Block::Iter::RestartKey(const uint32_t index,
+                             std::string_view* key) const {
+  EntryHeader h;
+  if (!DecodeEntry(block_->data_ + block_->RestartPoint(index),
+                   block_->data_ + block_->size_, block_->format_, &h) ||
+      h.shared != 0) {
+    return false;
+  }
+  *key = {h.key, h.non_shared};
+  if (block_->sequenced_) {
+    if (key->size() < sizeof(SequenceNumber)) return false;
+    key->remove_suffix(sizeof(SequenceNumber));
+  }
+  return true;
+}
+
+void Block::Iter::SeekToFirst() {
+  internal_key_ = {};
+  ParseAt(0);
+}
+
+void Block::Iter::Seek(const std::string_view target) {
+  uint64_t start = 0;
+  if (block_->num_restarts_ > 0) {
+    // 找最后一个 key < target 的重启点。同一个 key 的版本可能跨过重启点，
+    // 停在 key == target 的重启点上会漏掉它前面更新的版本。
+    // 重启点上的 key 是完整的，比较时不用拼接
+    uint32_t left = 0;
+    uint32_t right = block_->num_restarts_ - 1;
+    while (left < right) {
+      const uint32_t mid = left + (right - left + 1) / 2;
+      std::string_view key;
+      if (RestartKey(mid, &key) && key < target) {
+        left = mid;
+      } else {
+        right = mid - 1;
+      }
+    }
+    start = block_->RestartPoint(left);
+  }
+  // 从重启点往后扫，最多一个间隔就能到；旧格式块从头扫
+  internal_key_ = {};
+  for (ParseAt(start); valid_ && entry_.key < target; Next()) {
+  }
+}
+
+void Block::Iter::Next() { ParseAt(next_); }
+
+void Block::Iter::ParseAt(const uint64_t offset) {
+  EntryHeader h;
+  valid_ = DecodeEntry(block_->data_ + offset, block_->data_ + block_->size_,
+                       block_->format_, &h) &&
+           h.shared <= internal_key_.size();
+  if (!valid_) {
+    return;
+  }
+  if (h.shared == 0) {
+    // 完整的 key 直接指向块数据
+    internal_key_ = {h.key, h.non_shared};
+  } else {
+    // 上一条的 key 可能在块里也可能已经在缓冲里，先留下共享的前缀
+    if (internal_key_.data() == key_buf_.data()) {
+      key_buf_.resize(h.shared);
+    } else {
+      key_buf_.assign(internal_key_.data(), h.shared);
+    }
+    key_buf_.append(h.key, h.non_shared);
+    internal_key_ = key_buf_;
+  }
+  next_ = h.end - block_->data_;
+
+  entry_.key = internal_key_;
+  entry_.sequence = 0;
+  if (block_->sequenced_) {
+    if (internal_key_.size() < sizeof(SequenceNumber)) {
+      valid_ = false;
+      return;
+    }
+    entry_.key.remove_suffix(sizeof(SequenceNumber));
+    std::memcpy(&entry_.sequence, entry_.key.data() + entry_.key.size(),
+                sizeof(SequenceNumber));
+  }
+  entry_.type = h.type;
+  entry_.value = {h.value, h.value_len};
+}
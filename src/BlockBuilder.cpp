@@ -4,45 +4,72 @@
 
 #include "BlockBuilder.h"
 
-void BlockBuilder::Add(const std::string& key, const std::string& value,
-                       ValueType type) {
-  // 布局：[KeyLen (4B)] [Key 内容] [ValueType(1B)] [ValueLen (4B)] [Value 内容]
-  // 1. 获取长度
-  auto key_len = static_cast<uint32_t>(key.size());
-  auto val_len = static_cast<uint32_t>(value.size());
+#include <algorithm>
+
+#include "Coding.h"
+
+BlockBuilder::BlockBuilder(const int restart_interval)
+    : restart_interval_(std::max(restart_interval, 1)) {}
 
-  // 2. 将 Key 长度压入缓冲区 (模仿二进制序列化)
-  // 指针强转：把 uint32_t 的 4 个字节直接拷贝进 string
-  buffer_.append(reinterpret_cast<char*>(&key_len), sizeof(uint32_t));
+void BlockBuilder::Add(std::string_view key, std::string_view value,
+                       ValueType type) {
+  // 1. 每 restart_interval_ 条记录的第一条作为重启点，存完整的 key；
+  // 其余记录只存和上一条不同的后缀
+  size_t shared = 0;
+  if (counter_ % restart_interval_ == 0) {
+    restarts_.push_back(static_cast<uint32_t>(buffer_.size()));
+  } else {
+    const size_t min_len = std::min(last_key_.size(), key.size());
+    while (shared < min_len && last_key_[shared] == key[shared]) {
+      ++shared;
+    }
+  }
+  const size_t non_shared = key.size() - shared;
 
-  // 3. 将 Key 内容压入
-  buffer_.append(key);
+  // 2. 三个长度都用 varint：[Shared] [NonShared] [ValueLen]
+  PutVarint32(&buffer_, static_cast<uint32_t>(shared));
+  PutVarint32(&buffer_, static_cast<uint32_t>(non_shared));
+  PutVarint32(&buffer_, static_cast<uint32_t>(value.size()));
 
-  // 将 ValueType压入
+  // 3. 将 ValueType压入
   const auto t = static_cast<uint8_t>(type);
   buffer_.append(reinterpret_cast<const char*>(&t), sizeof(uint8_t));
 
-  // 4. 将 Value 长度压入
-  buffer_.append(reinterpret_cast<char*>(&val_len), sizeof(uint32_t));
-
-  // 5. 将 Value 内容压入
+  // 4. 将 Key 的后缀和 Value 内容压入
+  buffer_.append(key.substr(shared));
   buffer_.append(value);
 
-  // 6. 计数器增加
+  // 5. 记下完整的 key 给下一条算前缀，计数器增加
+  last_key_.resize(shared);
+  last_key_.append(key.substr(shared));
   counter_++;
 }
 
 std::string BlockBuilder::Finish() {
+  // 空块也写一个长度为 0 的重启点数组，读的时候不用特判
+  for (const uint32_t restart : restarts_) {
+    buffer_.append(reinterpret_cast<const char*>(&restart), sizeof(uint32_t));
+  }
+  const auto num_restarts = static_cast<uint32_t>(restarts_.size());
+  buffer_.append(reinterpret_cast<const char*>(&num_restarts),
+                 sizeof(uint32_t));
   finished_ = true;
   return buffer_;
 }
 
 void BlockBuilder::Reset() {
   buffer_.clear();
+  restarts_.clear();
+  last_key_.clear();
   counter_ = 0;
   finished_ = false;
 }
 
-size_t BlockBuilder::CurrentSizeEstimate() const { return buffer_.size(); }
+size_t BlockBuilder::CurrentSizeEstimate() const {
+  if (buffer_.empty()) {
+    return 0;
+  }
+  return buffer_.size() + (restarts_.size() + 1) * sizeof(uint32_t);
+}
 
 bool BlockBuilder::Empty() const { return buffer_.empty(); }
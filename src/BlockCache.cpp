@@ -0,0 +1,134 @@
+//
+// Created by 26708 on 2026/3/26.
+//
+
+#include "BlockCache.h"
+
+#include <utility>
+
+namespace {
+
+// 分片最多 64 个，每个分片至少 512KB：容量小时分片太多，
+// 一个分片放不下几个块，淘汰就不再是全局 LRU 了
+constexpr int kMaxShardBits = 6;
+constexpr size_t kMinShardCapacity = 512 * 1024;
+
+int ShardBitsFor(const size_t capacity) {
+  int bits = 0;
+  while (bits < kMaxShardBits &&
+         (capacity >> (bits + 1)) >= kMinShardCapacity) {
+    ++bits;
+  }
+  return bits;
+}
+
+}  // namespace
+
+size_t BlockCache::KeyHash::operator()(const Key& key) const {
+  // 同一个文件的相邻块要分散到不同分片
+  uint64_t h = key.file_number * 0x9E3779B97F4A7C15ULL ^ key.offset;
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDULL;
+  h ^= h >> 33;
+  return static_cast<size_t>(h);
+}
+
+BlockCache::BlockCache(const size_t capacity)
+    : capacity_(capacity), shard_bits_(ShardBitsFor(capacity)) {
+  const size_t shards = size_t{1} << shard_bits_;
+  shards_ = std::make_unique<Shard[]>(shards);
+  for (size_t i = 0; i < shards; ++i) {
+    shards_[i].capacity = capacity / shards;
+  }
+}
+
+BlockCache::Shard& BlockCache::ShardFor(const Key& key) const {
+  // 低位给分片内的哈希表用，分片取高位
+  const uint64_t h = KeyHash()(key);
+  return shards_[shard_bits_ == 0 ? 0 : h >> (64 - shard_bits_)];
+}
+
+std::shared_ptr<const Block> BlockCache::Lookup(const uint64_t file_number,
+                                                const uint64_t offset) {
+  const Key key{file_number, offset};
+  Shard& shard = ShardFor(key);
+  std::lock_guard lock(shard.mu);
+  const auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    ++shard.misses;
+    return nullptr;
+  }
+  ++shard.hits;
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  return it->second->block;
+}
+
+void BlockCache::Insert(const uint64_t file_number, const uint64_t offset,
+                        std::shared_ptr<const Block> block) {
+  const Key key{file_number, offset};
+  const size_t charge = block->Charge();
+  Shard& shard = ShardFor(key);
+  std::lock_guard lock(shard.mu);
+  if (charge > shard.capacity) {
+    return;
+  }
+  const auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    shard.usage -= it->second->charge;
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+  }
+  shard.lru.push_front({key, std::move(block), charge});
+  shard.index.emplace(key, shard.lru.begin());
+  shard.usage += charge;
+  shard.EvictLocked();
+}
+
+void BlockCache::Erase(const uint64_t file_number, const uint64_t offset) {
+  const Key key{file_number, offset};
+  Shard& shard = ShardFor(key);
+  std::lock_guard lock(shard.mu);
+  const auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    return;
+  }
+  shard.usage -= it->second->charge;
+  shard.lru.erase(it->second);
+  shard.index.erase(it);
+}
+
+void BlockCache::Shard::EvictLocked() {
+  while (usage > capacity && !lru.empty()) {
+    const Item& oldest = lru.back();
+    usage -= oldest.charge;
+    index.erase(oldest.key);
+    lru.pop_back();
+  }
+}
+
+size_t BlockCache::Usage() const {
+  size_t total = 0;
+  for (size_t i = 0; i < (size_t{1} << shard_bits_); ++i) {
+    std::lock_guard lock(shards_[i].mu);
+    total += shards_[i].usage;
+  }
+  return total;
+}
+
+uint64_t BlockCache::Hits() const {
+  uint64_t total = 0;
+  for (size_t i = 0; i < (size_t{1} << shard_bits_); ++i) {
+    std::lock_guard lock(shards_[i].mu);
+    total += shards_[i].hits;
+  }
+  return total;
+}
+
+uint64_t BlockCache::Misses() const {
+  uint64_t total = 0;
+  for (size_t i = 0; i < (size_t{1} << shard_bits_); ++i) {
+    std::lock_guard lock(shards_[i].mu);
+    total += shards_[i].misses;
+  }
+  return total;
+}
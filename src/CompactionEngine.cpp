@@ -6,36 +6,54 @@
 
 #include <algorithm>
 #include <filesystem>
-#include <map>
+#include <limits>
 #include <new>
 #include <utility>
 
 #include "FileFormats.h"
 #include "Logger.h"
+#include "MergingIterator.h"
 #include "SSTableBuilder.h"
 
 namespace fs = std::filesystem;
 
+namespace {
+
+// 同一个 key 从新到旧遍历版本时，newer 表示上一个保留下来的版本的序号，
+// 还没有保留任何版本时用它表示“没有更新的版本”
+constexpr SequenceNumber kNoNewerVersion =
+    std::numeric_limits<SequenceNumber>::max();
+
+// 序号为 sequence 的版本是否还有读者需要：最新视图或某个快照 p 满足
+// sequence <= p < newer，即它是这个读者能看到的最新版本。
+// snapshots 升序；每个读者只需要一个版本，被同一批读者看到的更旧版本可以丢掉
+bool VersionNeeded(const std::vector<SequenceNumber>& snapshots,
+                   const SequenceNumber sequence,
+                   const SequenceNumber newer) {
+  const auto it =
+      std::lower_bound(snapshots.begin(), snapshots.end(), sequence);
+  const SequenceNumber reader =
+      it == snapshots.end() ? kMaxSequenceNumber : *it;
+  return reader < newer;
+}
+
+}  // namespace
+
 CompactionEngine::CompactionEngine(
     std::string db_path, ManifestManager& manifest_manager,
-    std::vector<std::vector<SSTableReader*> >& levels)
+    std::vector<std::vector<FileMetaData> >& levels, TableCache& table_cache)
     : db_path_(std::move(db_path)),
       manifest_manager_(manifest_manager),
-      levels_(levels) {}
+      levels_(levels),
+      table_cache_(table_cache) {}
 
-bool CompactionEngine::PrepareL0ToL1(L0ToL1Ctx& ctx) const {
+bool CompactionEngine::PrepareL0ToL1(
+    const std::vector<SequenceNumber>& snapshots, L0ToL1Ctx& ctx) const {
   ctx = L0ToL1Ctx{};
   if (levels_[0].empty()) {
     return false;
   }
 
-  for (auto it = levels_[0].rbegin(); it != levels_[0].rend(); ++it) {
-    (*it)->ForEach([&](const std::string& key, const std::string& value,
-                       const ValueType type) {
-      ctx.merged_l0_records.try_emplace(key, ValueRecord{type, value});
-    });
-  }
-
   for (const auto& [id, level] : manifest_manager_.SstLevels()) {
     if (level == 0) {
       ctx.l0_input_ids.push_back(id);
@@ -47,24 +65,65 @@ bool CompactionEngine::PrepareL0ToL1(L0ToL1Ctx& ctx) const {
     return false;
   }
 
-  if (ctx.merged_l0_records.empty()) {
+  // 新的 L0 文件排在前面，序号相同（旧格式文件）时以新文件为准。
+  // 这些文件合并完就删了，读过的块不放进缓存。迭代器不持有 reader，
+  // 合并期间要自己留着引用，免得被 TableCache 淘汰关掉
+  std::vector<std::shared_ptr<SSTableReader> > inputs;
+  std::vector<std::unique_ptr<InternalIterator> > children;
+  for (auto it = levels_[0].rbegin(); it != levels_[0].rend(); ++it) {
+    std::shared_ptr<SSTableReader> table = table_cache_.Get(it->number);
+    if (table == nullptr) {
+      LOG_ERROR("PrepareL0ToL1 failed: cannot open L0 SST " +
+                std::to_string(it->number));
+      return false;
+    }
+    children.push_back(table->NewIterator(false));
+    inputs.push_back(std::move(table));
+  }
+  MergingIterator merged(std::move(children));
+
+  // 逐个 key 收集需要保留的版本，key 换了再决定最旧的 tombstone 能否丢掉
+  std::string current_key;
+  size_t key_begin = 0;
+  SequenceNumber newer = kNoNewerVersion;
+  auto finish_key = [&]() {
+    // 最旧的保留版本是 tombstone、L1 里又没有它要遮住的值时可以丢掉：
+    // L0 的序号都比 L1 大，能看到这个 tombstone 的读者在 L1 里只会看到
+    // 最新版本，而它本来就不可见
+    while (ctx.output_records.size() > key_begin &&
+           ctx.output_records.back().record.type == ValueType::kDeletion &&
+           !HasVisibleValueInL1(current_key)) {
+      ctx.output_records.pop_back();
+    }
+  };
+  for (; merged.Valid(); merged.Next()) {
+    ++ctx.input_records;
+    if (ctx.input_records == 1 || merged.key() != current_key) {
+      if (ctx.input_records > 1) {
+        finish_key();
+      }
+      current_key.assign(merged.key());
+      key_begin = ctx.output_records.size();
+      newer = kNoNewerVersion;
+    }
+    const SequenceNumber sequence = merged.sequence();
+    if (!VersionNeeded(snapshots, sequence, newer)) {
+      continue;
+    }
+    newer = sequence;
+    ctx.output_records.push_back(
+        {current_key, ValueRecord{merged.type(), std::string(merged.value()),
+                                  sequence}});
+  }
+  if (ctx.input_records == 0) {
     return true;
   }
+  finish_key();
 
   // 和旧逻辑保持一致：只要输入非空就先占用一个 file number。
   ctx.new_sst_id = manifest_manager_.AllocateFileNumber();
   ctx.new_sst_path = db_path_ + "/" + std::to_string(ctx.new_sst_id) + ".sst";
 
-  for (const auto& [key, record] : ctx.merged_l0_records) {
-    if (record.type == ValueType::kValue) {
-      ctx.output_records.emplace(key, record);
-      continue;
-    }
-    if (HasVisibleValueInL1(key)) {
-      ctx.output_records.emplace(key, ValueRecord{ValueType::kDeletion, ""});
-    }
-  }
-
   ctx.has_output = !ctx.output_records.empty();
   return true;
 }
@@ -87,12 +146,12 @@ SSTableReader* CompactionEngine::BuildL0ToL1SST(const L0ToL1Ctx& ctx) const {
   WritableFile file(ctx.new_sst_path);
   SSTableBuilder builder(&file);
   for (const auto& [key, record] : ctx.output_records) {
-    builder.Add(key, record.value, record.type);
+    builder.Add(key, record.value, record.type, record.sequence);
   }
   builder.Finish();
   file.Flush();
 
-  SSTableReader* reader = SSTableReader::Open(ctx.new_sst_path);
+  SSTableReader* reader = table_cache_.Open(ctx.new_sst_id);
   if (reader == nullptr) {
     LOG_ERROR(std::string("BuildL0ToL1SST failed: cannot open sstable: ") +
               ctx.new_sst_path);
@@ -105,6 +164,8 @@ SSTableReader* CompactionEngine::BuildL0ToL1SST(const L0ToL1Ctx& ctx) const {
 
 bool CompactionEngine::InstallL0ToL1(const L0ToL1Ctx& ctx,
                                      SSTableReader* reader) const {
+  // 旧的 L0 reader 只从 levels_ 摘掉：还在用它们的迭代器持有引用，
+  // 最后一个引用放开时才 munmap；文件已经 unlink，读映射不受影响
   if (levels_[0].size() != ctx.expected_l0_reader_count) {
     LOG_ERROR("InstallL0ToL1 failed: L0 reader count changed during build.");
     return false;
@@ -126,18 +187,16 @@ bool CompactionEngine::InstallL0ToL1(const L0ToL1Ctx& ctx,
   }
 
   auto consume_l0 = [&]() {
-    for (const auto* r : levels_[0]) {
-      delete r;
-    }
     levels_[0].clear();
 
     for (const uint64_t id : ctx.l0_input_ids) {
       manifest_manager_.RemoveSst(id);
-      fs::remove(fs::path(db_path_) / (std::to_string(id) + ".sst"));
+      table_cache_.Evict(id);
+      fs::remove(table_cache_.TablePath(id));
     }
   };
 
-  if (ctx.merged_l0_records.empty() || !ctx.has_output) {
+  if (ctx.input_records == 0 || !ctx.has_output) {
     consume_l0();
     return true;
   }
@@ -147,7 +206,7 @@ bool CompactionEngine::InstallL0ToL1(const L0ToL1Ctx& ctx,
     return false;
   }
 
-  levels_[1].push_back(reader);
+  levels_[1].push_back(table_cache_.Insert(ctx.new_sst_id, reader));
   manifest_manager_.AddSst(ctx.new_sst_id, 1);
   consume_l0();
   return true;
@@ -156,8 +215,16 @@ bool CompactionEngine::InstallL0ToL1(const L0ToL1Ctx& ctx,
 bool CompactionEngine::HasVisibleValueInL1(const std::string& key) const {
   if (levels_.size() <= 1) return false;
   for (size_t i = levels_[1].size(); i-- > 0;) {
+    const std::shared_ptr<SSTableReader> table =
+        table_cache_.Get(levels_[1][i].number);
+    if (table == nullptr) {
+      // 查不了就当它有：多留一个 tombstone 无害，丢了它旧值会复活
+      LOG_ERROR("HasVisibleValueInL1: cannot open L1 SST " +
+                std::to_string(levels_[1][i].number));
+      return true;
+    }
     ValueRecord rec{ValueType::kDeletion, ""};
-    if (levels_[1][i]->GetRecord(key, &rec)) {
+    if (table->GetRecord(key, &rec)) {
       if (rec.type == ValueType::kDeletion) {
         return false;
       }
@@ -185,16 +252,28 @@ SSTableReader* CompactionEngine::BuildMinorSST(const MinorCtx& ctx) const {
   WritableFile file(ctx.new_sst_path);
   SSTableBuilder builder(&file);
 
-  auto it = ctx.flushing_imm->GetIterator();
-  while (it.Valid()) {
-    builder.Add(it.key(), it.value().value, it.value().type);
-    it.Next();
+  // 只写最新视图和活着的快照还需要的版本；tombstone 都要留着，
+  // 它可能遮住更老的 L0 / L1 里的值
+  std::string_view current_key;
+  SequenceNumber newer = kNoNewerVersion;
+  for (auto it = ctx.flushing_imm->NewVersionIterator(); it->Valid();
+       it->Next()) {
+    // 第一条记录，或者换了一个 key
+    if (newer == kNoNewerVersion || it->key() != current_key) {
+      current_key = it->key();
+      newer = kNoNewerVersion;
+    }
+    if (!VersionNeeded(ctx.snapshots, it->sequence(), newer)) {
+      continue;
+    }
+    newer = it->sequence();
+    builder.Add(it->key(), it->value(), it->type(), it->sequence());
   }
   builder.Finish();
   file.Flush();
   LOG_INFO(std::string("SSTable created: ") + ctx.new_sst_path);
 
-  SSTableReader* reader = SSTableReader::Open(ctx.new_sst_path);
+  SSTableReader* reader = table_cache_.Open(ctx.new_sst_id);
   if (reader == nullptr) {
     LOG_ERROR(std::string("BuildMinorSST failed: cannot open sstable: ") +
               ctx.new_sst_path);
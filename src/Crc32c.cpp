@@ -0,0 +1,119 @@
+//
+// Created by 26708 on 2026/3/21.
+//
+
+#include "Crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define NOVAKV_CRC32C_SSE42 1
+#endif
+
+namespace crc32c {
+
+namespace {
+
+// 反射形式的 Castagnoli 多项式
+constexpr uint32_t kPoly = 0x82F63B78;
+
+// tables[0] 是普通的逐字节表；tables[k][b] 表示字节 b 后面再跟 k 个 0 字节的 CRC，
+// 这样 8 个字节可以各查一张表再异或到一起
+using Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+const Tables& SliceTables() {
+  static const Tables tables = []() {
+    Tables t{};
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t crc = i;
+      for (int j = 0; j < 8; ++j) {
+        crc = (crc >> 1) ^ (crc & 1 ? kPoly : 0);
+      }
+      t[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+      for (size_t k = 1; k < 8; ++k) {
+        t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+      }
+    }
+    return t;
+  }();
+  return tables;
+}
+
+// 按小端读 4 字节，和机器字节序无关
+inline uint32_t LoadLE32(const unsigned char* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) |
+         (static_cast<uint32_t>(p[3]) << 24);
+}
+
+#if defined(NOVAKV_CRC32C_SSE42)
+__attribute__((target("sse4.2"))) uint32_t ExtendSse42(const uint32_t crc,
+                                                       const char* data,
+                                                       size_t n) {
+  const auto* p = reinterpret_cast<const unsigned char*>(data);
+  uint64_t l = crc ^ 0xFFFFFFFFu;
+  // 先按字节对齐到 8，主循环每次喂 8 字节
+  while (n > 0 && (reinterpret_cast<uintptr_t>(p) & 7) != 0) {
+    l = _mm_crc32_u8(static_cast<uint32_t>(l), *p++);
+    --n;
+  }
+  while (n >= 8) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    l = _mm_crc32_u64(l, v);
+    p += 8;
+    n -= 8;
+  }
+  while (n > 0) {
+    l = _mm_crc32_u8(static_cast<uint32_t>(l), *p++);
+    --n;
+  }
+  return static_cast<uint32_t>(l) ^ 0xFFFFFFFFu;
+}
+
+bool DetectSse42() { return __builtin_cpu_supports("sse4.2"); }
+#else
+bool DetectSse42() { return false; }
+#endif
+
+}  // namespace
+
+uint32_t ExtendPortable(const uint32_t crc, const char* data, size_t n) {
+  const Tables& t = SliceTables();
+  const auto* p = reinterpret_cast<const unsigned char*>(data);
+  uint32_t l = crc ^ 0xFFFFFFFFu;
+  while (n >= 8) {
+    const uint32_t lo = LoadLE32(p) ^ l;
+    const uint32_t hi = LoadLE32(p + 4);
+    l = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF] ^ t[5][(lo >> 16) & 0xFF] ^
+        t[4][lo >> 24] ^ t[3][hi & 0xFF] ^ t[2][(hi >> 8) & 0xFF] ^
+        t[1][(hi >> 16) & 0xFF] ^ t[0][hi >> 24];
+    p += 8;
+    n -= 8;
+  }
+  while (n > 0) {
+    l = (l >> 8) ^ t[0][(l ^ *p++) & 0xFF];
+    --n;
+  }
+  return l ^ 0xFFFFFFFFu;
+}
+
+bool IsHardwareAccelerated() {
+  static const bool has_sse42 = DetectSse42();
+  return has_sse42;
+}
+
+uint32_t Extend(const uint32_t crc, const char* data, const size_t n) {
+#if defined(NOVAKV_CRC32C_SSE42)
+  if (IsHardwareAccelerated()) {
+    return ExtendSse42(crc, data, n);
+  }
+#endif
+  return ExtendPortable(crc, data, n);
+}
+
+}  // namespace crc32c
@@ -4,21 +4,74 @@
 
 #include "DBImpl.h"
 
+#include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <filesystem>
-#include <map>
 #include <stdexcept>
 #include <utility>
 
 #include "Logger.h"
+#include "MergingIterator.h"
 
 namespace fs = std::filesystem;
 
-DBImpl::DBImpl(std::string db_path)
+namespace {
+
+// 限速时一次最多睡这么久，醒来看看限速是不是已经解除了
+constexpr uint64_t kDelayStepMicros = 1000;
+
+// value 在软、硬上限之间走到了哪里：没到软上限返回负数，到了硬上限返回 1。
+// 上限为 0 表示不检查
+double StallPressure(const size_t value, const size_t slowdown,
+                     const size_t stop) {
+  if (stop > 0 && value >= stop) {
+    return 1.0;
+  }
+  if (slowdown == 0 || value < slowdown) {
+    return -1.0;
+  }
+  if (stop <= slowdown) {
+    return 0.0;
+  }
+  return static_cast<double>(value - slowdown) /
+         static_cast<double>(stop - slowdown);
+}
+
+const char* StallName(const WriteStallCondition condition) {
+  switch (condition) {
+    case WriteStallCondition::kDelayed:
+      return "delayed";
+    case WriteStallCondition::kStopped:
+      return "stopped";
+    case WriteStallCondition::kNormal:
+    default:
+      return "normal";
+  }
+}
+
+uint64_t MicrosSince(const std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+DBImpl::DBImpl(std::string db_path, DBOptions options)
     : db_path_(std::move(db_path)),
+      options_(options),
       manifest_manager_(db_path_),
+      block_cache_(options_.block_cache_capacity > 0
+                       ? std::make_shared<BlockCache>(
+                             options_.block_cache_capacity)
+                       : nullptr),
+      table_cache_(db_path_, options_.max_open_files, block_cache_),
       levels_(2),
-      compaction_engine_(db_path_, manifest_manager_, levels_),
-      recovery_loader_(db_path_, manifest_manager_, levels_),
+      compaction_engine_(db_path_, manifest_manager_, levels_, table_cache_),
+      recovery_loader_(db_path_, manifest_manager_, levels_, table_cache_,
+                       compaction_engine_),
+      write_controller_(options_.delayed_write_rate),
       bg_stopped_(false),
       bg_compaction_scheduled_(false) {
   // 1. 确保工作目录存在
@@ -37,22 +90,32 @@ DBImpl::DBImpl(std::string db_path)
   }
   recovery_loader_.LoadSSTables();
 
+  // 2. 上次没落盘的 WAL 回放成 L0，必须在分配新 WAL 之前，否则新 WAL 也会被当成待回放的
+  SequenceNumber last_sequence = 0;
+  if (!recovery_loader_.RecoverFromWals(options_.write_buffer_size,
+                                        &last_sequence)) {
+    throw std::runtime_error("RecoverFromWals failed");
+  }
+
+  LoadRecycledWals();
+
   // 3. 初始化第一个活跃的 MemTable
   // 每一个 MemTable 对应一个独立的日志文件
   const uint64_t new_wal_id = manifest_manager_.AllocateFileNumber();
   active_wal_id_ = new_wal_id;
-  const std::string wal_path =
-      db_path_ + "/" + std::to_string(new_wal_id) + ".wal";
-  mem_ = new MemTable(wal_path);
+  mem_ = NewMemTable(new_wal_id, last_sequence);
   manifest_manager_.AddWal(new_wal_id);
-
-  recovery_loader_.RecoverFromWals(mem_);
+  // 恢复出来的 L0 可能已经超过限速线，写线程第一次被挡住时会叫醒后台合并
+  UpdateWriteStall();
 
   // 构造函数最后启动后台进程
   background_thread_ = std::thread(&DBImpl::BackgroundLoop, this);
+  if (options_.wal_sync_mode == WalSyncMode::kPeriodic) {
+    wal_sync_thread_ = std::thread(&DBImpl::WalSyncLoop, this);
+  }
 
-  LOG_INFO(std::string("SSTs & WALs Recovery complete. Items in memory: ") +
-           std::to_string(mem_->Count()));
+  LOG_INFO(std::string("SSTs & WALs Recovery complete. L0 files: ") +
+           std::to_string(levels_[0].size()));
 }
 
 DBImpl::~DBImpl() {
@@ -65,28 +128,40 @@ DBImpl::~DBImpl() {
   if (background_thread_.joinable()) {
     background_thread_.join();
   }
+  {
+    std::lock_guard lock(wal_sync_mu_);
+    wal_sync_stopped_ = true;
+  }
+  wal_sync_cv_.notify_all();
+  if (wal_sync_thread_.joinable()) {
+    wal_sync_thread_.join();
+  }
 
-  // 析构前最后落盘一次，保证数据不丢
-  if (mem_ != nullptr && mem_->Count() > 0) {
-    // 此时已经是单线程了，直接手动把 mem 换给 imm 调一次 MinorCompaction 即可
-    imm_ = mem_;
-    imm_wal_id_ = active_wal_id_;
+  // 析构前最后落盘一次，保证数据不丢。WAL 坏了的表里可能有没确认的写入，
+  // 不落盘，已确认的部分下次启动时从它的 WAL 回放
+  if (mem_ != nullptr && mem_->Count() > 0 && !mem_->WalFailed()) {
+    // 此时已经是单线程了，直接手动把 mem 排到队尾，再把整个队列依次落盘
+    imms_.push_back({mem_, active_wal_id_});
     mem_ = nullptr;
+  }
+  while (!imms_.empty()) {
+    const size_t pending = imms_.size();
     MinorCompaction();
+    if (imms_.size() == pending) {
+      break;  // 落盘失败，剩下的交给下次启动时回放 WAL
+    }
+    MaybeCompactL0();
   }
 
   for (auto& level : levels_) {
-    for (const auto& reader : level) {
-      delete reader;
-    }
     level.clear();
   }
 
-  // 如果imm_非空，也清理掉
-  delete imm_;
+  // 落盘失败残留的 imm，也清理掉
+  imms_.clear();
 
   // 清理mem_
-  delete mem_;
+  mem_.reset();
 }
 
 void DBImpl::MinorCompaction() {
@@ -94,13 +169,17 @@ void DBImpl::MinorCompaction() {
   {
     std::unique_lock state_lock(state_mu_);
 
-    if (imm_ == nullptr) return;  // imm是空的，无需执行MinorCompaction
+    // 队列是空的，无需执行MinorCompaction
+    if (imms_.empty()) return;
 
-    ctx.flushing_imm = imm_;
+    // 每次只落盘最旧的一张，保证 L0 的新旧顺序和写入顺序一致
+    const ImmutableMemTable& oldest = imms_.front();
+    ctx.flushing_imm = oldest.table.get();
+    ctx.snapshots = LiveSnapshots();
     ctx.new_sst_id = manifest_manager_.AllocateFileNumber();
     ctx.new_sst_path = db_path_ + "/" + std::to_string(ctx.new_sst_id) + ".sst";
 
-    ctx.old_wal_id = imm_wal_id_;
+    ctx.old_wal_id = oldest.wal_id;
     ctx.old_wal_path = db_path_ + "/" + std::to_string(ctx.old_wal_id) + ".wal";
   }
 
@@ -115,38 +194,57 @@ void DBImpl::MinorCompaction() {
     minor_compact_count_++;
   }
 
-  bool trigger_l0_to_l1 = false;
   if (reader != nullptr) {
     std::unique_lock state_lock(state_mu_);
 
     // 更新磁盘元数据 (拿锁)
-    levels_[0].push_back(reader);
+    levels_[0].push_back(table_cache_.Insert(ctx.new_sst_id, reader));
     manifest_manager_.AddSst(ctx.new_sst_id, 0);
 
-    // 清理：删掉旧 WAL，删掉旧内存
+    // 清理：回收旧 WAL，删掉旧内存
     manifest_manager_.RemoveWal(ctx.old_wal_id);
-    std::filesystem::remove(ctx.old_wal_path);
+    RetireWal(ctx.old_wal_id);
 
-    delete imm_;
-    imm_ = nullptr;
-    imm_wal_id_ = 0;
+    // 只有落盘线程会弹出队头，前台只往队尾追加，所以队头仍是刚落盘的这张
+    imms_.pop_front();
+    UpdateWriteStall();
 
     LOG_INFO("Background Minor Compaction success.");
-
-    // 检查是否触发 L0->L1
-    if (levels_[0].size() >= 2) {
-      // CompactL0ToL1();
-      trigger_l0_to_l1 = true;
-    }
   } else {
     LOG_ERROR("Background Minor Compaction failed to build SST.");
   }
+}
 
-  if (trigger_l0_to_l1) {
-    // 触发 L0->L1
-    CompactL0ToL1();
+void DBImpl::MaybeCompactL0() {
+  size_t trigger = std::max<size_t>(options_.level0_compaction_trigger, 1);
+  // 停写线比合并触发值还低时按停写线合并，否则写线程会一直等下去
+  if (options_.level0_stop_writes_trigger > 0) {
+    trigger = std::min(trigger, options_.level0_stop_writes_trigger);
+  }
+  {
+    std::shared_lock state_lock(state_mu_);
+    if (levels_[0].size() < trigger) {
+      return;
+    }
+  }
+  CompactL0ToL1();
+}
+void DBImpl::WalSyncLoop() {
+  const auto interval =
+      std::chrono::milliseconds(options_.wal_sync_interval_ms);
+  std::unique_lock lock(wal_sync_mu_);
+  while (!wal_sync_cv_.wait_for(lock, interval,
+                                [this] { return wal_sync_stopped_; })) {
+    lock.unlock();
+    {
+      // 共享锁防止同步期间 mem_ 被切换释放，不挡写入
+      std::shared_lock state_lock(state_mu_);
+      mem_->SyncWal();
+    }
+    lock.lock();
   }
 }
+
 void DBImpl::BackgroundLoop() {
   while (true) {
     std::unique_lock state_lock(state_mu_);
@@ -159,9 +257,13 @@ void DBImpl::BackgroundLoop() {
     // 既然已经拿到锁了，我们可以执行 MinorCompaction
     state_lock.unlock();  // 先放锁，让 MinorCompaction 内部自己控锁
     MinorCompaction();
+    // 刚落盘的文件，或者停写的写线程叫醒后台时恢复留下的 L0
+    MaybeCompactL0();
     state_lock.lock();  // 干完活再拿回锁，重置状态
 
-    bg_compaction_scheduled_ = false;
+    // 队列里还有 imm（排队的，或者做 L0->L1 期间前台新切出来的）就接着落盘，
+    // 不能清掉调度标志，否则它们永远没人落盘，写线程会一直卡在 MakeRoomForWrite
+    bg_compaction_scheduled_ = !imms_.empty();
     bg_cv_.notify_all();  // 通知前台Compaction完成
   }
   // 醒来后提醒
@@ -172,7 +274,7 @@ void DBImpl::CompactL0ToL1() {
   CompactionEngine::L0ToL1Ctx ctx;
   {
     std::unique_lock state_lock(state_mu_);
-    if (!compaction_engine_.PrepareL0ToL1(ctx)) {
+    if (!compaction_engine_.PrepareL0ToL1(LiveSnapshots(), ctx)) {
       return;
     }
   }
@@ -196,7 +298,9 @@ void DBImpl::CompactL0ToL1() {
         fs::remove(ctx.new_sst_path);
       }
       LOG_ERROR("DBImpl::CompactL0ToL1 aborted: InstallL0ToL1 failed.");
+      return;
     }
+    UpdateWriteStall();
   }
 }
 
@@ -205,140 +309,448 @@ size_t DBImpl::LevelSize(const size_t level) const {
   return levels_[level].size();
 }
 
-std::unique_ptr<DBIterator> DBImpl::NewIterator() {
+std::unique_ptr<DBIterator> DBImpl::NewIterator() { return NewIterator(""); }
+
+std::unique_ptr<DBIterator> DBImpl::NewIterator(const std::string& start_key) {
+  return NewIterator(ReadOptions(), start_key);
+}
+
+std::unique_ptr<DBIterator> DBImpl::NewIterator(
+    const ReadOptions& read_options, const std::string& start_key) {
+  std::vector<std::unique_ptr<InternalIterator> > children;
+  DBIterator::Pins pins;
+  SequenceNumber sequence;
+  {
+    // 锁内只收集各层的引用和迭代器，不读数据；之后切换 MemTable、
+    // 落盘、Compaction 都不影响这个迭代器
+    std::shared_lock state_lock(state_mu_);
+    sequence = read_options.snapshot != nullptr
+                   ? read_options.snapshot->sequence()
+                   : mem_->VisibleSequence();
+    // 从新到旧：mem、imm 队列（队尾最新）、L0（逆序）、L1（逆序）
+    children.push_back(mem_->NewVersionIterator());
+    pins.memtables.push_back(mem_);
+    for (auto imm = imms_.rbegin(); imm != imms_.rend(); ++imm) {
+      children.push_back(imm->table->NewVersionIterator());
+      pins.memtables.push_back(imm->table);
+    }
+    for (const auto& level : levels_) {
+      for (auto l = level.rbegin(); l != level.rend(); ++l) {
+        std::shared_ptr<SSTableReader> table = table_cache_.Get(l->number);
+        if (table == nullptr) {
+          LOG_ERROR("NewIterator failed: cannot open SST " +
+                    std::to_string(l->number));
+          ++read_errors_;
+          return nullptr;
+        }
+        children.push_back(table->NewIterator());
+        pins.tables.push_back(std::move(table));
+      }
+    }
+  }
+
+  return std::make_unique<DBIterator>(
+      std::make_unique<MergingIterator>(std::move(children)), sequence,
+      std::move(pins), start_key);
+}
+
+const Snapshot* DBImpl::GetSnapshot() {
+  // 共享锁挡住 Compaction 的准备阶段：序号拿到手和登记之间
+  // 不会有 Compaction 按旧的快照列表丢掉它需要的版本
   std::shared_lock state_lock(state_mu_);
-  std::vector<std::pair<std::string, std::string> > rows;
-  std::map<std::string, ValueRecord> seen;
-  // 同 key 只保留最新版本，先从mem开始
-  // 最新是 kDeletion 就不放入 rows_
-  // 最后按 key 升序生成 rows_
-  if (mem_) {
-    auto s = mem_->Snapshot();
-    for (auto& [k, rec] : s) seen.try_emplace(k, rec);
-  }
-  if (imm_) {
-    auto s = imm_->Snapshot();
-    for (auto& [k, rec] : s) seen.try_emplace(k, rec);
-  }
-
-  // 之后是L0，从新到旧，要逆序遍历
-  for (auto l = levels_[0].rbegin(); l != levels_[0].rend(); ++l) {
-    (*l)->ForEach([&](const std::string& key, const std::string& value,
-                      const ValueType type) {
-      seen.try_emplace(key, ValueRecord{type, value});
-    });
-  }
-
-  // L1 同上
-  for (auto l = levels_[1].rbegin(); l != levels_[1].rend(); ++l) {
-    (*l)->ForEach([&](const std::string& key, const std::string& value,
-                      const ValueType type) {
-      seen.try_emplace(key, ValueRecord{type, value});
-    });
-  }
-
-  for (const auto& [fst, snd] : seen) {
-    if (snd.type == ValueType::kValue) {
-      rows.emplace_back(fst, snd.value);
+  const SequenceNumber sequence = mem_->VisibleSequence();
+  std::lock_guard lock(snapshots_mu_);
+  snapshots_.insert(sequence);
+  return new Snapshot(sequence);
+}
+
+void DBImpl::ReleaseSnapshot(const Snapshot* snapshot) {
+  if (snapshot == nullptr) {
+    return;
+  }
+  {
+    std::lock_guard lock(snapshots_mu_);
+    const auto it = snapshots_.find(snapshot->sequence());
+    if (it != snapshots_.end()) {
+      snapshots_.erase(it);
     }
   }
+  delete snapshot;
+}
 
-  return std::make_unique<DBIterator>(std::move(rows));
+std::vector<SequenceNumber> DBImpl::LiveSnapshots() const {
+  std::lock_guard lock(snapshots_mu_);
+  return {snapshots_.begin(), snapshots_.end()};
 }
+
 void DBImpl::Sync() {
   std::unique_lock state_lock(state_mu_);
   bg_cv_.wait(state_lock,
-              [this] { return imm_ == nullptr && !bg_compaction_scheduled_; });
+              [this] { return imms_.empty() && !bg_compaction_scheduled_; });
+}
+
+bool DBImpl::Get(const std::string& key, ValueRecord& value,
+                 const ReadOptions& read_options) const {
+  PinnedValue pinned;
+  if (!GetPinned(key, read_options, &pinned, &value.sequence)) {
+    return false;
+  }
+  value.type = ValueType::kValue;
+  value.value.assign(pinned.value());
+  return true;
+}
+
+bool DBImpl::Get(const std::string& key, PinnedValue* value,
+                 const ReadOptions& read_options) const {
+  return GetPinned(key, read_options, value, nullptr);
 }
 
-bool DBImpl::Get(const std::string& key, ValueRecord& value) const {
+bool DBImpl::GetPinned(const std::string& key, const ReadOptions& read_options,
+                       PinnedValue* value, SequenceNumber* sequence) const {
+  value->Reset();
   std::shared_lock lock(state_mu_);
-  // 第一级：查找活跃内存 (MemTable)
-  if (mem_ && mem_->Get(key, value)) {
+  // 没给快照就读已公布的最新序号，正在写的半批不可见
+  const SequenceNumber snapshot = read_options.snapshot != nullptr
+                                      ? read_options.snapshot->sequence()
+                                      : mem_->VisibleSequence();
+  ValueType type;
+  SequenceNumber found = 0;
+  std::string_view view;
+  // 第一级：查找活跃内存 (MemTable)，value 指向它的 Arena
+  if (mem_ && mem_->GetView(key, &type, &found, &view, snapshot)) {
     // 如果是kValue，返回true
     // 如果是kDeletion，返回false
-    if (value.type == ValueType::kValue) {
+    if (type == ValueType::kValue) {
       LOG_DEBUG(std::string("Get hit: memtable key=") + key);
+      value->Pin(view, mem_);
+      if (sequence != nullptr) {
+        *sequence = found;
+      }
       return true;
     }
     return false;
   }
 
-  // 第二级：查找只读内存 (Immutable MemTable)
-  // 注意：如果 MinorCompaction 正在进行，imm_ 里的数据也是最新的
-  if (imm_ && imm_->Get(key, value)) {
-    if (value.type == ValueType::kValue) {
-      LOG_DEBUG(std::string("Get hit: immutable memtable key=") + key);
-      return true;
+  // 第二级：查找只读内存 (Immutable MemTable)，从最新的一张往回查
+  // 注意：如果 MinorCompaction 正在进行，队头那张的数据也比磁盘上的新
+  for (auto imm = imms_.rbegin(); imm != imms_.rend(); ++imm) {
+    if (imm->table->GetView(key, &type, &found, &view, snapshot)) {
+      if (type == ValueType::kValue) {
+        LOG_DEBUG(std::string("Get hit: immutable memtable key=") + key);
+        value->Pin(view, imm->table);
+        if (sequence != nullptr) {
+          *sequence = found;
+        }
+        return true;
+      }
+      return false;
     }
-    return false;
   }
 
   // 第三级：查找磁盘 SSTable (从新到旧)
   // 越晚生成的 SST 文件，数据越新，所以要逆序遍历
-  // 先倒序遍历 levels_[0]（L0 新到旧）
-  for (size_t i = levels_[0].size(); i-- > 0;) {
-    ValueRecord rec{ValueType::kDeletion, ""};
-    if (levels_[0][i]->GetRecord(key, &rec)) {
-      if (rec.type == ValueType::kDeletion) return false;
-      value = rec;
-      return true;
+  // 先倒序遍历 levels_[0]（L0 新到旧），再查 L1
+  for (const auto& level : levels_) {
+    for (size_t i = level.size(); i-- > 0;) {
+      const std::shared_ptr<SSTableReader> table =
+          table_cache_.Get(level[i].number);
+      if (table == nullptr) {
+        // 跳过它去查更旧的文件，可能读到已经被覆盖或删除的值
+        LOG_ERROR("Get failed: cannot open SST " +
+                  std::to_string(level[i].number));
+        ++read_errors_;
+        return false;
+      }
+      if (table->GetPinned(key, snapshot, table, &type, &found, value)) {
+        if (type == ValueType::kDeletion) {
+          value->Reset();
+          return false;
+        }
+        if (sequence != nullptr) {
+          *sequence = found;
+        }
+        return true;
+      }
     }
   }
 
-  for (size_t i = levels_[1].size(); i-- > 0;) {
-    ValueRecord rec{ValueType::kDeletion, ""};
-    if (levels_[1][i]->GetRecord(key, &rec)) {
-      if (rec.type == ValueType::kDeletion) return false;
-      value = rec;
-      return true;
+  return false;
+}
+
+bool DBImpl::Put(const std::string& key, const ValueRecord& value,
+                 const WriteOptions& write_options) {
+  DelayWrite(key.size() + value.value.size());
+  while (true) {
+    {
+      // 共享锁只防止 mem_ 被切换，多个写线程可以同时往同一个 MemTable 插入
+      std::shared_lock state_lock(state_mu_);
+      if (mem_->WalFailed()) {
+        return false;
+      }
+      if (mem_->ApproximateMemoryUsage() < options_.write_buffer_size) {
+        return mem_->Put(key, value, write_options.sync);
+      }
     }
+    // MemTable 已满：放掉共享锁，去拿独占锁切换
+    MakeRoomForWrite(false);
   }
+}
 
-  return false;
+bool DBImpl::Write(const WriteBatch& batch, const WriteOptions& write_options) {
+  if (batch.Count() == 0) {
+    return true;
+  }
+  DelayWrite(batch.ApproximateSize());
+  while (true) {
+    {
+      // 和 Put 一样只拿共享锁：整批插完才公布序号，读者看不到半批。
+      // 批内多条记录只付一次锁和一次 WAL 写的开销
+      std::shared_lock state_lock(state_mu_);
+      if (mem_->WalFailed()) {
+        return false;
+      }
+      if (mem_->ApproximateMemoryUsage() < options_.write_buffer_size) {
+        return mem_->Write(batch, write_options.sync);
+      }
+    }
+    MakeRoomForWrite(false);
+  }
 }
 
-void DBImpl::Put(const std::string& key, const ValueRecord& value) {
-  std::lock_guard write_lock(write_mu_);
+void DBImpl::MakeRoomForWrite(const bool force) {
+  std::unique_lock state_lock(state_mu_);
+  while (true) {
+    // WAL 坏了的表不能切走落盘（见 MemTable::WalFailed），写入会直接失败
+    if (mem_->WalFailed()) {
+      break;
+    }
+    // 拿到独占锁后要重新检查：可能别的写线程已经切换过了
+    if (!force &&
+        mem_->ApproximateMemoryUsage() < options_.write_buffer_size) {
+      break;
+    }
+    // 空 MemTable 没必要落盘
+    if (force && mem_->Count() == 0) {
+      break;
+    }
+    if (imms_.size() >=
+        std::max<size_t>(options_.max_immutable_memtables, 1)) {
+      // imm 队列已排满，只能等后台落掉一张
+      const auto start = std::chrono::steady_clock::now();
+      bg_cv_.wait(state_lock);
+      write_stop_micros_ += MicrosSince(start);
+    } else {
+      // 队列还有空位，直接切换，不用等后台
+      SwitchMemTable();
+      break;
+    }
+  }
+}
 
-  {
-    std::unique_lock state_lock(state_mu_);
-    // 1. 检查当前 MemTable 是否已满 (假设阈值为 10000 条)
-    while (mem_->Count() >= 10000) {
-      if (imm_ != nullptr) {
-        bg_cv_.wait(state_lock);
-      } else {
-        // 此时 imm_ 为空，我们可以安全地切换
-        imm_wal_id_ = active_wal_id_;
-        imm_ = mem_;
-        // 创建新 WAL 和新 MemTable (这部分很快，可以在锁内做)
-        uint64_t new_wal_id = manifest_manager_.AllocateFileNumber();
-        std::string new_wal =
-            db_path_ + "/" + std::to_string(new_wal_id) + ".wal";
-        mem_ = new MemTable(new_wal);
-        active_wal_id_ = new_wal_id;
-        manifest_manager_.AddWal(new_wal_id);
-
-        // 唤醒后台
-        bg_compaction_scheduled_ = true;
-        bg_cv_.notify_all();
-        break;
+void DBImpl::SwitchMemTable() {
+  // 定时同步只盯着活跃 WAL，切走之前把尾巴同步掉。同步失败就不切了，
+  // 这张表留在原地，之后的写入都会失败
+  if (options_.wal_sync_mode == WalSyncMode::kPeriodic && !mem_->SyncWal()) {
+    return;
+  }
+  imms_.push_back({mem_, active_wal_id_});
+  UpdateWriteStall();
+  // 创建新 WAL 和新 MemTable (这部分很快，可以在锁内做)。
+  // 持独占锁时没有进行中的写入，旧表已分配的序号都已公布
+  uint64_t new_wal_id = manifest_manager_.AllocateFileNumber();
+  mem_ = NewMemTable(new_wal_id, mem_->VisibleSequence());
+  active_wal_id_ = new_wal_id;
+  manifest_manager_.AddWal(new_wal_id);
+
+  // 唤醒后台
+  bg_compaction_scheduled_ = true;
+  bg_cv_.notify_all();
+}
+
+std::shared_ptr<MemTable> DBImpl::NewMemTable(
+    const uint64_t wal_id, const SequenceNumber last_sequence) {
+  const std::string wal_path = db_path_ + "/" + std::to_string(wal_id) + ".wal";
+  WalOpenOptions wal_options;
+  if (options_.wal_preallocate) {
+    wal_options.preallocate_bytes =
+        options_.write_buffer_size + options_.write_buffer_size / 4;
+  }
+  if (options_.recycle_wal_files > 0) {
+    // 开了复用就一律用可复用格式，这样它落盘后才能被安全地覆盖
+    wal_options.log_number = wal_id;
+    while (!recycled_wals_.empty() && !wal_options.recycle) {
+      const std::string old_path =
+          db_path_ + "/" + std::to_string(recycled_wals_.front()) + ".recycle";
+      recycled_wals_.pop_front();
+      std::error_code ec;
+      fs::rename(old_path, wal_path, ec);
+      wal_options.recycle = !ec;
+      if (ec) {
+        fs::remove(old_path, ec);
       }
     }
   }
 
-  // 2. 正常写入
-  mem_->Put(key, value);
+  // 一条记录在 Arena 里至少占几十字节，按 64 字节一条估算槽位，
+  // 小 value 场景下表会偏满，探测过长的 key 会自动退回跳表查找
+  const size_t hash_index_slots =
+      options_.memtable_hash_index ? options_.write_buffer_size / 64 : 0;
+  auto table = std::make_shared<MemTable>(
+      wal_path, 16, hash_index_slots, options_.memtable_rep, wal_options,
+      options_.pipelined_write);
+  table->GetWalHandler()->SetSyncPolicy(options_.wal_sync_mode,
+                                        options_.wal_bytes_per_sync);
+  table->SetLastSequence(last_sequence);
+  return table;
+}
+
+void DBImpl::RetireWal(const uint64_t wal_id) {
+  const std::string wal_path = db_path_ + "/" + std::to_string(wal_id) + ".wal";
+  if (recycled_wals_.size() < options_.recycle_wal_files) {
+    // 改名后不再是 .wal，崩溃恢复不会回放里面已经落盘的旧数据
+    std::error_code ec;
+    fs::rename(wal_path,
+               db_path_ + "/" + std::to_string(wal_id) + ".recycle", ec);
+    if (!ec) {
+      recycled_wals_.push_back(wal_id);
+      return;
+    }
+  }
+  fs::remove(wal_path);
+}
+
+void DBImpl::LoadRecycledWals() {
+  std::vector<uint64_t> ids;
+  for (const auto& entry : fs::directory_iterator(db_path_)) {
+    if (!entry.is_regular_file() || entry.path().extension() != ".recycle") {
+      continue;
+    }
+    const std::string stem = entry.path().stem().string();
+    if (stem.empty() ||
+        !std::all_of(stem.begin(), stem.end(),
+                     [](const unsigned char c) { return std::isdigit(c); })) {
+      continue;
+    }
+    ids.push_back(std::stoull(stem));
+  }
+  std::sort(ids.begin(), ids.end());
+  for (const uint64_t id : ids) {
+    if (recycled_wals_.size() < options_.recycle_wal_files) {
+      recycled_wals_.push_back(id);
+    } else {
+      fs::remove(db_path_ + "/" + std::to_string(id) + ".recycle");
+    }
+  }
+}
+
+void DBImpl::DelayWrite(const size_t bytes) {
+  // 限速：按令牌桶睡够了再写，中途限速解除了就不再睡
+  uint64_t delay = write_controller_.GetDelay(bytes);
+  if (delay > 0) {
+    const auto start = std::chrono::steady_clock::now();
+    while (delay > 0 &&
+           write_controller_.condition() == WriteStallCondition::kDelayed) {
+      const uint64_t step = std::min(delay, kDelayStepMicros);
+      std::this_thread::sleep_for(std::chrono::microseconds(step));
+      delay -= step;
+    }
+    write_delay_micros_ += MicrosSince(start);
+  }
+
+  if (write_controller_.condition() != WriteStallCondition::kStopped) {
+    return;
+  }
+  std::unique_lock state_lock(state_mu_);
+  const auto start = std::chrono::steady_clock::now();
+  while (!bg_stopped_ &&
+         write_controller_.condition() == WriteStallCondition::kStopped) {
+    // 后台闲着时积压不会自己消失（比如恢复留下的 L0），叫醒它去合并
+    if (!bg_compaction_scheduled_) {
+      bg_compaction_scheduled_ = true;
+      bg_cv_.notify_all();
+    }
+    bg_cv_.wait(state_lock);
+  }
+  write_stop_micros_ += MicrosSince(start);
+}
+
+void DBImpl::UpdateWriteStall() {
+  size_t flush_bytes = 0;
+  for (const auto& imm : imms_) {
+    flush_bytes += imm.table->ApproximateMemoryUsage();
+  }
+  const size_t l0_files = levels_[0].size();
+  size_t compaction_bytes = 0;
+  if (l0_files >= std::max<size_t>(options_.level0_compaction_trigger, 1)) {
+    for (const FileMetaData& meta : levels_[0]) {
+      compaction_bytes += meta.file_size;
+    }
+  }
+
+  // 取最重的那一类积压
+  const double pressure = std::max(
+      {StallPressure(l0_files, options_.level0_slowdown_writes_trigger,
+                     options_.level0_stop_writes_trigger),
+       StallPressure(flush_bytes, options_.pending_flush_slowdown_bytes,
+                     options_.pending_flush_stop_bytes),
+       StallPressure(compaction_bytes,
+                     options_.pending_compaction_slowdown_bytes,
+                     options_.pending_compaction_stop_bytes)});
+  WriteStallCondition condition = WriteStallCondition::kNormal;
+  if (pressure >= 1.0) {
+    condition = WriteStallCondition::kStopped;
+  } else if (pressure >= 0.0) {
+    condition = WriteStallCondition::kDelayed;
+  }
+
+  const WriteStallCondition old_condition = write_controller_.condition();
+  write_controller_.SetCondition(condition, pressure);
+  if (condition == old_condition) {
+    return;
+  }
+  LOG_INFO(std::string("Write stall ") + StallName(condition) +
+           ": L0 files " + std::to_string(l0_files) + ", pending flush " +
+           std::to_string(flush_bytes) + "B, pending compaction " +
+           std::to_string(compaction_bytes) + "B");
+  if (old_condition == WriteStallCondition::kStopped) {
+    // 叫醒停写的写线程
+    bg_cv_.notify_all();
+  }
+}
+
+void DBImpl::FlushMemTable() {
+  MakeRoomForWrite(true);
+  Sync();
 }
 
 DBStatus DBImpl::GetStatus() const {
   std::shared_lock state_lock(state_mu_);
   DBStatus s;
   s.mem_count = mem_ ? mem_->Count() : 0;
-  s.imm_count = imm_ ? imm_->Count() : 0;
+  s.imm_count = 0;
+  s.imm_tables = imms_.size();
+  s.mem_bytes = mem_ ? mem_->ApproximateMemoryUsage() : 0;
+  s.imm_bytes = 0;
+  for (const auto& imm : imms_) {
+    s.imm_count += imm.table->Count();
+    s.imm_bytes += imm.table->ApproximateMemoryUsage();
+  }
   s.l0_count = levels_[0].size();
   s.l1_count = levels_[1].size();
   s.minor_compact_count = minor_compact_count_.load();
   s.last_minor_duration_ms = last_minor_duration_ms_.load();
+  s.write_stall = write_controller_.condition();
+  s.delayed_write_rate = write_controller_.delayed_write_rate();
+  s.write_delay_micros = write_delay_micros_.load();
+  s.write_stop_micros = write_stop_micros_.load();
+  s.block_cache_hits = block_cache_ ? block_cache_->Hits() : 0;
+  s.block_cache_misses = block_cache_ ? block_cache_->Misses() : 0;
+  s.block_cache_usage = block_cache_ ? block_cache_->Usage() : 0;
+  s.open_tables = table_cache_.OpenFiles();
+  s.read_errors = read_errors_.load();
+  const WalHandler* wal = mem_ ? mem_->GetWalHandler() : nullptr;
+  s.wal_syncs = wal ? wal->SyncCount() : 0;
+  s.wal_unsynced_bytes = wal ? wal->UnsyncedBytes() : 0;
+  s.wal_failed = wal != nullptr && wal->Failed();
   return s;
 }
@@ -6,31 +6,61 @@
 
 #include <algorithm>
 #include <cassert>
-#include <string>
+#include <utility>
+
+#include "MemTable.h"
+#include "SSTableReader.h"
+
+DBIterator::DBIterator(std::unique_ptr<InternalIterator> iter,
+                       const SequenceNumber sequence, Pins pins,
+                       std::string lower_bound)
+    : pins_(std::move(pins)),
+      iter_(std::move(iter)),
+      sequence_(sequence),
+      lower_bound_(std::move(lower_bound)) {
+  Seek(lower_bound_);
+}
+
 void DBIterator::Seek(const std::string& start_key) {
-  // 把游标定位到第一个 >= start_key 的可见记录
-  auto it =
-      std::lower_bound(rows_.begin(), rows_.end(), start_key,
-                       [](const std::pair<std::string, std::string>& element,
-                          const std::string& val) {
-                         return element.first < val;  // 只比较 Key
-                       });
-  pos_ = it - rows_.begin();
+  // 把游标定位到第一个 >= start_key 的可见记录，不会越过起点往前
+  iter_->Seek(std::max(start_key, lower_bound_));
+  FindNextUserEntry(false);
 }
+
 void DBIterator::Next() {
   if (Valid()) {
-    ++pos_;
+    FindNextUserEntry(true);
   }
 }
-bool DBIterator::Valid() const { return pos_ < rows_.size(); }
+
+void DBIterator::FindNextUserEntry(bool skipping) {
+  for (; iter_->Valid(); iter_->Next()) {
+    // 快照之后的写入
+    if (iter_->sequence() > sequence_) {
+      continue;
+    }
+    // 同一个 key 只认快照内最新的那一版，更旧的都跳过
+    if (skipping && iter_->key() == key_) {
+      continue;
+    }
+    key_.assign(iter_->key());
+    if (iter_->type() == ValueType::kDeletion) {
+      skipping = true;
+      continue;
+    }
+    value_.assign(iter_->value());
+    valid_ = true;
+    return;
+  }
+  valid_ = false;
+}
+
+bool DBIterator::Valid() const { return valid_; }
 const std::string& DBIterator::key() const {
   assert(Valid());
-  return rows_[pos_].first;
+  return key_;
 }
 const std::string& DBIterator::value() const {
   assert(Valid());
-  return rows_[pos_].second;
+  return value_;
 }
-
-DBIterator::DBIterator(std::vector<std::pair<std::string, std::string>>&& rows)
-    : rows_(std::move(rows)), pos_(0) {}
@@ -0,0 +1,156 @@
+//
+// Created by 26708 on 2026/3/19.
+//
+
+#include "MemTableRep.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+class SkipListRepIterator : public MemTableRep::Iterator {
+ public:
+  explicit SkipListRepIterator(SkipListRep::Table::Iterator it) : it_(it) {}
+
+  bool Valid() const override { return it_.Valid(); }
+  void Next() override { it_.Next(); }
+  void Seek(const std::string_view target) override { it_.Seek(target); }
+  std::string_view key() const override { return it_.key(); }
+  const char* record() const override { return it_.value(); }
+
+ private:
+  SkipListRep::Table::Iterator it_;
+};
+
+// 持有一份排好序的 Entry 拷贝（每条只有两个指针），
+// 之后 VectorRep 再追加写入也不会影响正在进行的遍历
+class VectorRepIterator : public MemTableRep::Iterator {
+ public:
+  explicit VectorRepIterator(std::vector<VectorRep::Entry> entries)
+      : entries_(std::move(entries)) {}
+
+  bool Valid() const override { return pos_ < entries_.size(); }
+  void Next() override { ++pos_; }
+  void Seek(const std::string_view target) override {
+    const auto it = std::lower_bound(
+        entries_.begin(), entries_.end(), target,
+        [](const VectorRep::Entry& e, const std::string_view k) {
+          return e.key < k;
+        });
+    pos_ = it - entries_.begin();
+  }
+  std::string_view key() const override { return entries_[pos_].key; }
+  const char* record() const override { return entries_[pos_].record; }
+
+ private:
+  std::vector<VectorRep::Entry> entries_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+std::unique_ptr<MemTableRep> MemTableRep::Create(
+    const MemTableRepType type, Arena* arena, const LinkFn link,
+    const int max_level, const size_t hash_index_slots) {
+  switch (type) {
+    case MemTableRepType::kVector:
+      return std::make_unique<VectorRep>(link);
+    case MemTableRepType::kSkipList:
+    default:
+      return std::make_unique<SkipListRep>(arena, link, max_level,
+                                           hash_index_slots);
+  }
+}
+
+SkipListRep::SkipListRep(Arena* arena, const LinkFn link,
+                         const int max_level, const size_t hash_index_slots)
+    : link_(link),
+      table_(max_level, arena),
+      hash_index_(hash_index_slots > 0
+                      ? std::make_unique<HashIndex>(hash_index_slots)
+                      : nullptr) {}
+
+void SkipListRep::Insert(const std::string_view key, const char* record) {
+  Table::Node* node = table_.insert_node(key, record, link_);
+  // 先挂跳表再登记索引：索引里出现的节点一定已经对迭代器可见
+  if (hash_index_) {
+    hash_index_->Insert(node);
+  }
+}
+
+bool SkipListRep::Get(const std::string_view key, const char** record) const {
+  if (hash_index_) {
+    const Table::Node* node = hash_index_->Find(key);
+    if (node != nullptr) {
+      *record = Table::node_value(node);
+      return true;
+    }
+    // 索引完整时未命中就是真的没有，省掉一次跳表查找
+    if (hash_index_->complete()) {
+      return false;
+    }
+  }
+  return table_.search_element(key, *record);
+}
+
+std::unique_ptr<MemTableRep::Iterator> SkipListRep::NewIterator() const {
+  return std::make_unique<SkipListRepIterator>(table_.begin());
+}
+
+void VectorRep::Insert(const std::string_view key, const char* record) {
+  std::lock_guard lock(mu_);
+  // 追加的 key 比队尾大时仍然有序（顺序导入的常态），省掉之后的排序
+  if (sorted_ && !entries_.empty() && !(entries_.back().key < key)) {
+    sorted_ = false;
+  }
+  const size_t old_capacity = entries_.capacity();
+  entries_.push_back({key, record});
+  if (entries_.capacity() != old_capacity) {
+    bytes_.store(entries_.capacity() * sizeof(Entry),
+                 std::memory_order_relaxed);
+  }
+  count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void VectorRep::SortLocked() const {
+  if (sorted_) {
+    return;
+  }
+  // 稳定排序后同 key 的记录相邻，逐个串进第一条的版本链
+  std::stable_sort(
+      entries_.begin(), entries_.end(),
+      [](const Entry& a, const Entry& b) { return a.key < b.key; });
+  size_t out = 0;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    if (out > 0 && entries_[out - 1].key == entries_[i].key) {
+      if (link_(entries_[out - 1].record, entries_[i].record)) {
+        entries_[out - 1].record = entries_[i].record;
+      }
+      continue;
+    }
+    entries_[out++] = entries_[i];
+  }
+  entries_.resize(out);
+  count_.store(static_cast<int>(out), std::memory_order_relaxed);
+  sorted_ = true;
+}
+
+bool VectorRep::Get(const std::string_view key, const char** record) const {
+  std::lock_guard lock(mu_);
+  SortLocked();
+  const auto it = std::lower_bound(
+      entries_.begin(), entries_.end(), key,
+      [](const Entry& e, const std::string_view k) { return e.key < k; });
+  if (it == entries_.end() || it->key != key) {
+    return false;
+  }
+  *record = it->record;
+  return true;
+}
+
+std::unique_ptr<MemTableRep::Iterator> VectorRep::NewIterator() const {
+  std::lock_guard lock(mu_);
+  SortLocked();
+  return std::make_unique<VectorRepIterator>(entries_);
+}
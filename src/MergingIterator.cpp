@@ -0,0 +1,47 @@
+//
+// Created by 26708 on 2026/3/24.
+//
+
+#include "MergingIterator.h"
+
+#include <utility>
+
+MergingIterator::MergingIterator(
+    std::vector<std::unique_ptr<InternalIterator>> children)
+    : children_(std::move(children)) {
+  FindSmallest();
+}
+
+void MergingIterator::SeekToFirst() {
+  for (const auto& child : children_) {
+    child->SeekToFirst();
+  }
+  FindSmallest();
+}
+
+void MergingIterator::Seek(const std::string_view target) {
+  for (const auto& child : children_) {
+    child->Seek(target);
+  }
+  FindSmallest();
+}
+
+void MergingIterator::Next() {
+  current_->Next();
+  FindSmallest();
+}
+
+void MergingIterator::FindSmallest() {
+  current_ = nullptr;
+  for (const auto& child : children_) {
+    if (!child->Valid()) {
+      continue;
+    }
+    // 严格小于才替换，相同 (key, sequence) 保留更靠前（更新）的孩子
+    if (current_ == nullptr || child->key() < current_->key() ||
+        (child->key() == current_->key() &&
+         child->sequence() > current_->sequence())) {
+      current_ = child.get();
+    }
+  }
+}
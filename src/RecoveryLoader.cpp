@@ -6,24 +6,77 @@
 
 #include <algorithm>
 #include <cctype>
+#include <deque>
 #include <filesystem>
+#include <future>
+#include <memory>
+#include <thread>
 #include <utility>
 
 #include "Logger.h"
 #include "WalHandler.h"
+#include "network/ThreadPool.h"
 
 namespace fs = std::filesystem;
 
+namespace {
+struct WalEntry {
+  SequenceNumber sequence;
+  ValueType type;
+  std::string key;
+  std::string value;
+};
+
+// 在工作线程里读完一个 WAL 并校验，只产出记录，不碰 MemTable
+std::vector<WalEntry> ParseWal(const std::string &path) {
+  std::vector<WalEntry> entries;
+  WalHandler handler(path);
+  handler.LoadLogWithSequence(
+      [&entries](const SequenceNumber sequence, const ValueType type,
+                 const std::string &k, const std::string &v) {
+        entries.push_back({sequence, type, k, v});
+      });
+  return entries;
+}
+}  // namespace
+
 RecoveryLoader::RecoveryLoader(
     std::string db_path, ManifestManager &manifest_manager,
-    std::vector<std::vector<SSTableReader *> > &levels)
+    std::vector<std::vector<FileMetaData> > &levels, TableCache &table_cache,
+    const CompactionEngine &compaction_engine)
     : db_path_(std::move(db_path)),
       manifest_manager_(manifest_manager),
-      levels_(levels) {}
+      levels_(levels),
+      table_cache_(table_cache),
+      compaction_engine_(compaction_engine) {}
+
+bool RecoveryLoader::FlushRecovered(MemTable *mem) const {
+  CompactionEngine::MinorCtx ctx;
+  ctx.flushing_imm = mem;
+  ctx.new_sst_id = manifest_manager_.AllocateFileNumber();
+  ctx.new_sst_path = db_path_ + "/" + std::to_string(ctx.new_sst_id) + ".sst";
+  SSTableReader *reader = compaction_engine_.BuildMinorSST(ctx);
+  if (reader == nullptr) {
+    return false;
+  }
+  // WAL 里的数据比已有的 SST 都新，排在 L0 队尾
+  levels_[0].push_back(table_cache_.Insert(ctx.new_sst_id, reader));
+  manifest_manager_.AddSst(ctx.new_sst_id, 0);
+  return true;
+}
 
-void RecoveryLoader::RecoverFromWals(MemTable *mem) const {
+bool RecoveryLoader::RecoverFromWals(const size_t write_buffer_size,
+                                     SequenceNumber *last_sequence) const {
   LOG_INFO(std::string("Recover from wals start"));
 
+  // 没有序号的 WAL 记录（旧格式）接着 SST 里最大的序号往下编
+  SequenceNumber sequence = 0;
+  for (const auto &level : levels_) {
+    for (const FileMetaData &meta : level) {
+      sequence = std::max(sequence, meta.max_sequence);
+    }
+  }
+
   for (auto &entry : fs::directory_iterator(db_path_)) {
     if (!entry.is_regular_file() || entry.path().extension() != ".wal") {
       continue;
@@ -41,25 +94,76 @@ void RecoveryLoader::RecoverFromWals(MemTable *mem) const {
                          manifest_manager_.LiveWals().end());
   std::sort(replay_ids.begin(), replay_ids.end());
 
+  std::vector<std::string> wal_paths;
   for (const uint64_t id : replay_ids) {
     const std::string wal_path = db_path_ + "/" + std::to_string(id) + ".wal";
     if (!fs::exists(wal_path)) {
       LOG_WARN(std::string("Manifest WAL missing on disk: ") + wal_path);
       continue;
     }
-    WalHandler handler(wal_path);
-    handler.LoadLog(
-        [mem](const ValueType type, const std::string &k,
-              const std::string &v) { mem->ApplyWithoutWal(k, {type, v}); });
+    wal_paths.push_back(wal_path);
+  }
+
+  // 解析和校验是纯 CPU 活，交给线程池并行做；应用必须按文件号顺序，
+  // 在当前线程里逐个取结果。最多同时持有 threads + 1 个解析结果，
+  // 内存占用和 WAL 的数量无关
+  const size_t threads =
+      std::clamp<size_t>(std::thread::hardware_concurrency(), 1,
+                         std::max<size_t>(1, wal_paths.size()));
+  Ayu::ThreadPool pool(threads);
+  std::deque<std::future<std::vector<WalEntry> > > parsing;
+  size_t next = 0;
+  const auto submit = [&]() {
+    while (next < wal_paths.size() && parsing.size() < threads + 1) {
+      parsing.push_back(pool.enqueue(&ParseWal, wal_paths[next++]));
+    }
+  };
+  submit();
+
+  // 临时 MemTable 不写 WAL，记录已经在原来的 WAL 里了；
+  // 回放沿用 WAL 里的序号，换表时接着上一张的序号
+  auto mem = std::make_unique<MemTable>("");
+  mem->SetLastSequence(sequence);
+  bool ok = true;
+  size_t recovered = 0;
+  while (!parsing.empty()) {
+    std::vector<WalEntry> entries = parsing.front().get();
+    parsing.pop_front();
+    submit();
+    for (WalEntry &entry : entries) {
+      mem->ApplyWithoutWal(entry.key,
+                           ValueRecord{entry.type, std::move(entry.value)},
+                           entry.sequence);
+      if (mem->ApproximateMemoryUsage() >= write_buffer_size) {
+        ok = FlushRecovered(mem.get()) && ok;
+        sequence = mem->VisibleSequence();
+        mem = std::make_unique<MemTable>("");
+        mem->SetLastSequence(sequence);
+      }
+    }
+    recovered += entries.size();
+  }
+  if (mem->Count() > 0) {
+    ok = FlushRecovered(mem.get()) && ok;
+  }
+  *last_sequence = mem->VisibleSequence();
+
+  // 数据都进了 L0 才能删 WAL；否则留着下次再回放，重复落盘的内容是一样的
+  if (ok) {
+    for (const uint64_t id : replay_ids) {
+      manifest_manager_.RemoveWal(id);
+      fs::remove(db_path_ + "/" + std::to_string(id) + ".wal");
+    }
   }
-  LOG_INFO(std::string("Recover from wals completed"));
+  LOG_INFO(std::string("Recover from wals completed, records: ") +
+           std::to_string(recovered));
+  return ok;
 }
 
 void RecoveryLoader::LoadSSTables() const {
   LOG_INFO(std::string("LoadSSTables start"));
 
   for (auto &lv : levels_) {
-    for (const auto *r : lv) delete r;
     lv.clear();
   }
 
@@ -76,14 +180,15 @@ void RecoveryLoader::LoadSSTables() const {
         continue;
       }
 
-      const std::string path = db_path_ + "/" + std::to_string(id) + ".sst";
+      const std::string path = table_cache_.TablePath(id);
       if (!fs::exists(path)) {
         LOG_ERROR("Manifest SST missing: " + path);
         continue;
       }
 
-      if (SSTableReader *reader = SSTableReader::Open(path)) {
-        levels_[level].push_back(reader);
+      FileMetaData meta;
+      if (table_cache_.ReadMetaData(id, &meta)) {
+        levels_[level].push_back(meta);
       } else {
         LOG_ERROR("Failed to open manifest SST: " + path);
       }
@@ -108,8 +213,9 @@ void RecoveryLoader::LoadSSTables() const {
   std::sort(sstables.begin(), sstables.end());
 
   for (const auto &[id, path] : sstables) {
-    if (SSTableReader *reader = SSTableReader::Open(path)) {
-      levels_[0].push_back(reader);
+    FileMetaData meta;
+    if (table_cache_.ReadMetaData(id, &meta)) {
+      levels_[0].push_back(meta);
       manifest_manager_.SetSstLevelWithoutEdit(id, 0);
     }
   }
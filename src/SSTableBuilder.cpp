@@ -4,21 +4,32 @@
 
 #include "SSTableBuilder.h"
 
+#include <algorithm>
+
 #include "Logger.h"
 
 SSTableBuilder::SSTableBuilder(WritableFile* file) : file_(file) {}
 
-void SSTableBuilder::Add(const std::string& key, const std::string& value,
-                         ValueType type) {
+void SSTableBuilder::Add(std::string_view key, std::string_view value,
+                         ValueType type, const SequenceNumber sequence) {
+  // 同一个 key 的版本必须落在同一个块里：索引按用户 key 定位，只会查一个块
+  const bool new_key = data_block_.Empty() || key != last_key_;
+
   // 1. 如果当前 BlockBuilder 已经够大了（如 4KB），执行 Flush()
-  if (data_block_.CurrentSizeEstimate() >= 4096) {
+  if (new_key && data_block_.CurrentSizeEstimate() >= 4096) {
     WriteDataBlock();
   }
 
-  // 2. 将数据喂给 BlockBuilder
-  data_block_.Add(key, value, type);
+  // 2. 将数据喂给 BlockBuilder，key 后面拼上序号
+  internal_key_.assign(key);
+  internal_key_.append(reinterpret_cast<const char*>(&sequence),
+                       sizeof(sequence));
+  data_block_.Add(internal_key_, value, type);
+  max_sequence_ = std::max(max_sequence_, sequence);
   // 收集 Key 用于布隆过滤器
-  keys_.push_back(key);
+  if (new_key) {
+    keys_.emplace_back(key);
+  }
 
   // 3. 更新当前文件的最大 Key
   last_key_ = key;  // 持续更新，直到 Block 结束，它就是 Last Key
@@ -45,6 +56,7 @@ void SSTableBuilder::Finish() {
   Footer footer;
   footer.index_handle = index_handle;
   footer.filter_handle = filter_handle_;
+  footer.max_sequence = max_sequence_;
 
   std::string footer_encoding;
   footer.EncodeTo(&footer_encoding);
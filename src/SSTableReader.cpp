@@ -10,13 +10,102 @@
 
 #include <algorithm>
 #include <cstring>
+#include <utility>
 
 #include "BloomFilter.h"
 #include "Logger.h"
 
+namespace {
+
+// 在块里找 key 的第一个序号 <= snapshot 的版本：重启点上二分到这个 key
+// 最新的版本，再往后找快照能看到的那一版。found 里只有 value、type、
+// sequence 可用，value 指向块数据
+bool FindVersion(const Block& block, const std::string& key,
+                 const SequenceNumber snapshot, Block::Entry* found) {
+  Block::Iter it(&block);
+  for (it.Seek(key); it.Valid() && it.entry().key == key; it.Next()) {
+    if (it.entry().sequence > snapshot) continue;  // 快照之后写入的版本
+    *found = it.entry();
+    return true;
+  }
+  // 这个 Block 里没有这个 Key
+  return false;
+}
+
+}  // namespace
+
+// 按块顺序遍历，Seek 先用索引定位到块再在块内按重启点二分
+class SSTableReader::Iterator : public InternalIterator {
+ public:
+  Iterator(const SSTableReader* table, const bool fill_cache)
+      : table_(table), fill_cache_(fill_cache) {
+    SeekToFirst();
+  }
+
+  bool Valid() const override { return iter_.Valid(); }
+  void SeekToFirst() override {
+    SeekToBlock(0);
+    if (block_ != nullptr) {
+      iter_.SeekToFirst();
+    }
+    SkipEmptyBlocks();
+  }
+  void Seek(const std::string_view target) override {
+    const auto& index = table_->index_entries_;
+    const auto it = std::lower_bound(
+        index.begin(), index.end(), target,
+        [](const IndexEntry& entry, const std::string_view k) {
+          return entry.last_key < k;
+        });
+    SeekToBlock(it - index.begin());
+    if (block_ != nullptr) {
+      iter_.Seek(target);
+    }
+    SkipEmptyBlocks();
+  }
+  void Next() override {
+    iter_.Next();
+    SkipEmptyBlocks();
+  }
+
+  std::string_view key() const override { return iter_.entry().key; }
+  SequenceNumber sequence() const override { return iter_.entry().sequence; }
+  ValueType type() const override { return iter_.entry().type; }
+  std::string_view value() const override { return iter_.entry().value; }
+
+ private:
+  void SeekToBlock(const size_t block_index) {
+    const auto& index = table_->index_entries_;
+    block_index_ = block_index;
+    block_ = block_index_ < index.size()
+                 ? table_->ReadBlock(index[block_index_].handle, fill_cache_)
+                 : nullptr;
+    iter_ = Block::Iter(block_.get());
+  }
+
+  // 当前块读完了就换下一块，直到停在一条记录上或者整个文件读完
+  void SkipEmptyBlocks() {
+    while (!iter_.Valid() && block_ != nullptr) {
+      SeekToBlock(block_index_ + 1);
+      if (block_ != nullptr) {
+        iter_.SeekToFirst();
+      }
+    }
+  }
+
+  const SSTableReader* table_;
+  const bool fill_cache_;
+  size_t block_index_ = 0;
+  // 当前块，持有引用，被缓存淘汰了也还能读
+  std::shared_ptr<const Block> block_;
+  Block::Iter iter_{nullptr};
+};
+
 SSTableReader::SSTableReader() : fd_(-1), data_(MAP_FAILED), file_size_(0) {}
 
 SSTableReader::~SSTableReader() {
+  // reader 可能只是被 TableCache 淘汰，文件还在，缓存的块以后还能用；
+  // 文件删除时由 EraseCachedBlocks 清掉
   if (data_ != MAP_FAILED) {
     munmap(data_, file_size_);
   }
@@ -25,7 +114,9 @@ SSTableReader::~SSTableReader() {
   }
 }
 
-SSTableReader* SSTableReader::Open(const std::string& filename) {
+SSTableReader* SSTableReader::Open(const std::string& filename,
+                                   const uint64_t file_number,
+                                   std::shared_ptr<BlockCache> cache) {
   // 1. 打开文件 (POSIX 标准)
   int fd = open(filename.c_str(), O_RDONLY);
   if (fd < 0) {
@@ -35,12 +126,13 @@ SSTableReader* SSTableReader::Open(const std::string& filename) {
 
   // 2. 获取文件大小
   struct stat st{};
-  if (fstat(fd, &st) != 0 || st.st_size < Footer::kEncodedLength) {
+  if (fstat(fd, &st) != 0 || st.st_size < 0 ||
+      static_cast<size_t>(st.st_size) < Footer::kLegacyEncodedLength) {
     LOG_ERROR(std::string("Invalid SSTable size: ") + filename);
     close(fd);
     return nullptr;
   }
-  size_t size = st.st_size;
+  const auto size = static_cast<size_t>(st.st_size);
   LOG_DEBUG(std::string("SSTable file size: ") + std::to_string(size));
 
   // 3. 内存映射 (mmap)
@@ -57,6 +149,8 @@ SSTableReader* SSTableReader::Open(const std::string& filename) {
   reader->fd_ = fd;
   reader->data_ = mmap_ptr;
   reader->file_size_ = size;
+  reader->file_number_ = file_number;
+  reader->cache_ = std::move(cache);
 
   // 5. 校验 Footer (这是进入 SSTable 世界的入场券)
   if (!reader->ReadFooter()) {
@@ -85,14 +179,53 @@ SSTableReader* SSTableReader::Open(const std::string& filename) {
   return reader;
 }
 
+bool SSTableReader::ReadFileFooter(const std::string& filename,
+                                   Footer* footer, uint64_t* file_size) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG_ERROR(std::string("Failed to open file: ") + filename);
+    return false;
+  }
+  struct stat st{};
+  bool ok = fstat(fd, &st) == 0 && st.st_size >= 0 &&
+            static_cast<uint64_t>(st.st_size) >= Footer::kLegacyEncodedLength;
+  if (ok) {
+    const auto size = static_cast<uint64_t>(st.st_size);
+    // 旧格式的 Footer 更短，多读的几个字节由 DecodeFrom 忽略
+    const size_t length = std::min<uint64_t>(size, Footer::kEncodedLength);
+    std::string footer_buf(length, '\0');
+    ok = pread(fd, footer_buf.data(), length,
+               static_cast<off_t>(size - length)) ==
+             static_cast<ssize_t>(length) &&
+         footer->DecodeFrom(footer_buf);
+    *file_size = size;
+  }
+  close(fd);
+  if (!ok) {
+    LOG_ERROR(std::string("Invalid SSTable file (footer check failed): ") +
+              filename);
+  }
+  return ok;
+}
+
+void SSTableReader::EraseCachedBlocks() const {
+  if (cache_ == nullptr) {
+    return;
+  }
+  for (const auto& entry : index_entries_) {
+    cache_->Erase(file_number_, entry.handle.offset);
+  }
+}
+
 // 内部读取逻辑
 bool SSTableReader::ReadFooter() {
-  // 逻辑：定位到内存末尾的 24 字节
+  // 逻辑：定位到内存末尾的 Footer，旧格式的 Footer 更短，由 DecodeFrom 区分
+  const size_t length = std::min(file_size_, Footer::kEncodedLength);
   const char* footer_ptr =
-      static_cast<const char*>(data_) + file_size_ - Footer::kEncodedLength;
+      static_cast<const char*>(data_) + file_size_ - length;
 
-  // 将这 24 字节转为 string 供 DecodeFrom 使用
-  std::string footer_buf(footer_ptr, Footer::kEncodedLength);
+  // 将这段字节转为 string 供 DecodeFrom 使用
+  std::string footer_buf(footer_ptr, length);
 
   return footer_.DecodeFrom(footer_buf);
 }
@@ -103,45 +236,25 @@ bool SSTableReader::ReadIndexBlock() {
   uint64_t size = footer_.index_handle.size;
 
   // 边界安全检查：索引块不能超出文件范围
-  if (offset + size > file_size_ - Footer::kEncodedLength) {
+  if (offset + size > file_size_ - footer_.EncodedLength()) {
     return false;
   }
 
-  // 2. 定位到索引块起始指针
-  const char* index_ptr = static_cast<const char*>(data_) + offset;
-
-  // 3. 解析二进制数据
-  // 提示：我们在写入时是按照 [KeyLen][Key][ValueType][Offset][Size] 循环写入的
-  uint64_t pos = 0;
-  while (pos < size) {
+  // 2. 索引块也是一个 Block：Key 是数据块的 Last Key，
+  // Value 是 BlockHandle (Offset 8B + Size 8B)
+  const Block index_block(static_cast<const char*>(data_) + offset, size,
+                          false, footer_.block_format);
+  Block::Iter it(&index_block);
+  for (it.SeekToFirst(); it.Valid(); it.Next()) {
+    const Block::Entry& e = it.entry();
+    if (e.value.size() < 2 * sizeof(uint64_t)) {
+      return false;
+    }
     IndexEntry entry;
-
-    // 读取 Key 长度 (uint32_t)
-    uint32_t key_len;
-    std::memcpy(&key_len, index_ptr + pos, sizeof(uint32_t));
-    pos += sizeof(uint32_t);
-
-    // 读取 Key 字符串
-    entry.last_key.assign(index_ptr + pos, key_len);
-    pos += key_len;
-
-    // 读取 ValueType
-    uint8_t type;
-    std::memcpy(&type, index_ptr + pos, sizeof(uint8_t));
-    pos += sizeof(uint8_t);
-
-    // 读取 Value 长度 (uint32_t)，其实就是一个标准BlockHandle
-    uint32_t val_len;
-    std::memcpy(&val_len, index_ptr + pos, sizeof(uint32_t));
-    pos += sizeof(uint32_t);
-
-    // 读取 BlockHandle (Offset 和 Size)
-    // 读取 Offset
-    memcpy(&entry.handle.offset, index_ptr + pos, sizeof(uint64_t));
-    pos += sizeof(uint64_t);
-    // 读取 Size
-    memcpy(&entry.handle.size, index_ptr + pos, sizeof(uint64_t));
-    pos += sizeof(uint64_t);
+    entry.last_key.assign(e.key);
+    std::memcpy(&entry.handle.offset, e.value.data(), sizeof(uint64_t));
+    std::memcpy(&entry.handle.size, e.value.data() + sizeof(uint64_t),
+                sizeof(uint64_t));
 
     // 添加到索引列表中
     index_entries_.push_back(entry);
@@ -160,12 +273,12 @@ bool SSTableReader::Get(const std::string& key, std::string* value) {
   return true;
 }
 
-bool SSTableReader::GetRecord(const std::string& key, ValueRecord* record) {
+const BlockHandle* SSTableReader::LocateBlock(const std::string& key) const {
   // 查过滤器
-  // 如果过滤器说肯定不在，直接返回 false，省去后面的索引查找和数据块解析
+  // 如果过滤器说肯定不在，直接返回，省去后面的索引查找和数据块解析
   if (!filter_data_.empty() && !BloomFilter::KeyMayMatch(key, filter_data_)) {
     LOG_DEBUG(std::string("BloomFilter blocked key: ") + key);
-    return false;
+    return nullptr;
   }
 
   // 二分找block
@@ -177,55 +290,94 @@ bool SSTableReader::GetRecord(const std::string& key, ValueRecord* record) {
                              });
   // 如果没找到符合条件的 Block，说明 key 大于文件中所有的 key
   if (it == index_entries_.end()) {
-    return false;
+    return nullptr;
   }
+  // 同一个 key 的版本都在这一块里
+  return &it->handle;
+}
 
-  // 根据索引条目定位到具体的 Data Block
-  const char* block_ptr = static_cast<const char*>(data_) + it->handle.offset;
-  uint64_t block_size = it->handle.size;
-
-  // 在 Data Block 内部进行扫描
-  // Data Block 布局: [KeyLen][Key][ValLen][Val] ...
-  uint64_t pos = 0;
-  while (pos < block_size) {
-    // 解析 KeyLen
-    uint32_t curr_key_len;
-    memcpy(&curr_key_len, block_ptr + pos, sizeof(uint32_t));
-    pos += sizeof(uint32_t);
-
-    // 解析 Key
-    std::string curr_key(block_ptr + pos, curr_key_len);
-    pos += curr_key_len;
-
-    // 解析ValueType
-    uint8_t vtype;
-    memcpy(&vtype, block_ptr + pos, sizeof(uint8_t));
-    const auto type = static_cast<ValueType>(vtype);
-    pos += sizeof(uint8_t);
-
-    // 解析 ValLen
-    uint32_t val_len;
-    memcpy(&val_len, block_ptr + pos, sizeof(uint32_t));
-    pos += sizeof(uint32_t);
-
-    // 匹配检查
-    if (curr_key == key) {
-      record->type = type;
-      if (type == ValueType::kValue) {
-        record->value.assign(block_ptr + pos, val_len);
-      } else {
-        // 如果是kDeletion
-        record->value.clear();
-      }
-      return true;
+bool SSTableReader::GetRecord(const std::string& key, ValueRecord* record,
+                              const SequenceNumber snapshot) const {
+  const BlockHandle* handle = LocateBlock(key);
+  if (handle == nullptr) {
+    return false;
+  }
+  // 没有缓存时直接在 mmap 上查，不分配内存
+  Block::Entry entry;
+  std::shared_ptr<const Block> block;
+  if (cache_ == nullptr) {
+    if (!FindVersion(Block(BlockData(*handle), handle->size,
+                           footer_.sequenced, footer_.block_format),
+                     key, snapshot, &entry)) {
+      return false;
+    }
+  } else {
+    block = ReadBlock(*handle, true);
+    if (!FindVersion(*block, key, snapshot, &entry)) {
+      return false;
     }
+  }
+
+  record->type = entry.type;
+  if (entry.type == ValueType::kValue) {
+    record->value.assign(entry.value);
+  } else {
+    // 如果是kDeletion
+    record->value.clear();
+  }
+  record->sequence = entry.sequence;
+  return true;
+}
 
-    // 没找着，跳过当前 Value 继续扫下一个 KV
-    pos += val_len;
+bool SSTableReader::GetPinned(const std::string& key,
+                              const SequenceNumber snapshot,
+                              const std::shared_ptr<const void>& owner,
+                              ValueType* type, SequenceNumber* sequence,
+                              PinnedValue* value) const {
+  const BlockHandle* handle = LocateBlock(key);
+  if (handle == nullptr) {
+    return false;
   }
+  Block::Entry entry;
+  if (cache_ == nullptr) {
+    if (!FindVersion(Block(BlockData(*handle), handle->size,
+                           footer_.sequenced, footer_.block_format),
+                     key, snapshot, &entry)) {
+      return false;
+    }
+    // value 指向 mmap，reader 活着映射就在
+    value->Pin(entry.value, owner);
+  } else {
+    // 经过缓存的块都是自己持有数据的拷贝，pin 住这一块就够了，
+    // 被淘汰或者 reader 析构都不影响
+    std::shared_ptr<const Block> block = ReadBlock(*handle, true);
+    if (!FindVersion(*block, key, snapshot, &entry)) {
+      return false;
+    }
+    value->Pin(entry.value, std::move(block));
+  }
+  *type = entry.type;
+  *sequence = entry.sequence;
+  return true;
+}
 
-  // 这个 Block 里没有这个 Key
-  return false;
+std::shared_ptr<const Block> SSTableReader::ReadBlock(
+    const BlockHandle& handle, const bool fill_cache) const {
+  if (cache_ != nullptr) {
+    if (auto block = cache_->Lookup(file_number_, handle.offset)) {
+      return block;
+    }
+    if (fill_cache) {
+      // 要进缓存的块拷贝一份，之后不再依赖 mmap 的页缓存
+      auto block = Block::Copy(BlockData(handle), handle.size,
+                               footer_.sequenced, footer_.block_format);
+      cache_->Insert(file_number_, handle.offset, block);
+      return block;
+    }
+  }
+  return std::make_shared<const Block>(BlockData(handle), handle.size,
+                                       footer_.sequenced,
+                                       footer_.block_format);
 }
 
 bool SSTableReader::ReadFilterBlock() {
@@ -246,38 +398,21 @@ bool SSTableReader::ReadFilterBlock() {
 void SSTableReader::ForEach(
     const std::function<void(const std::string&, const std::string&,
                              ValueType)>& cb) const {
-  for (const auto& entry : index_entries_) {
-    uint64_t pos = 0;
-    const uint64_t block_size = entry.handle.size;
-    const char* block_ptr =
-        static_cast<const char*>(data_) + entry.handle.offset;
-
-    while (pos < block_size) {
-      if (pos + sizeof(uint32_t) > block_size) break;
-      uint32_t key_len;
-      std::memcpy(&key_len, block_ptr + pos, sizeof(uint32_t));
-      pos += sizeof(uint32_t);
-
-      if (pos + key_len > block_size) break;
-      std::string key(block_ptr + pos, key_len);
-      pos += key_len;
-
-      if (pos + sizeof(uint8_t) > block_size) break;
-      uint8_t vtype;
-      memcpy(&vtype, block_ptr + pos, sizeof(uint8_t));
-      const auto type = static_cast<ValueType>(vtype);
-      pos += sizeof(uint8_t);
-
-      if (pos + sizeof(uint32_t) > block_size) break;
-      uint32_t val_len;
-      std::memcpy(&val_len, block_ptr + pos, sizeof(uint32_t));
-      pos += sizeof(uint32_t);
-
-      if (pos + val_len > block_size) break;
-      std::string value(block_ptr + pos, val_len);
-      pos += val_len;
-
-      cb(key, value, type);
+  std::string key;
+  std::string value;
+  for (const auto& index_entry : index_entries_) {
+    const std::shared_ptr<const Block> block =
+        ReadBlock(index_entry.handle, false);
+    Block::Iter it(block.get());
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+      key.assign(it.entry().key);
+      value.assign(it.entry().value);
+      cb(key, value, it.entry().type);
     }
   }
 }
+
+std::unique_ptr<InternalIterator> SSTableReader::NewIterator(
+    const bool fill_cache) const {
+  return std::make_unique<Iterator>(this, fill_cache);
+}
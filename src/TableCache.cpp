@@ -0,0 +1,112 @@
+//
+// Created by 26708 on 2026/3/29.
+//
+
+#include "TableCache.h"
+
+#include <algorithm>
+
+#include "Logger.h"
+
+TableCache::TableCache(std::string db_path, const size_t max_open_files,
+                       std::shared_ptr<BlockCache> block_cache)
+    : db_path_(std::move(db_path)),
+      capacity_(std::max<size_t>(max_open_files, 1)),
+      block_cache_(std::move(block_cache)) {}
+
+std::string TableCache::TablePath(const uint64_t file_number) const {
+  return db_path_ + "/" + std::to_string(file_number) + ".sst";
+}
+
+bool TableCache::ReadMetaData(const uint64_t file_number,
+                              FileMetaData* meta) const {
+  Footer footer;
+  uint64_t file_size = 0;
+  if (!SSTableReader::ReadFileFooter(TablePath(file_number), &footer,
+                                     &file_size)) {
+    return false;
+  }
+  meta->number = file_number;
+  meta->file_size = file_size;
+  meta->max_sequence = footer.max_sequence;
+  return true;
+}
+
+SSTableReader* TableCache::Open(const uint64_t file_number) const {
+  return SSTableReader::Open(TablePath(file_number), file_number,
+                             block_cache_);
+}
+
+std::shared_ptr<SSTableReader> TableCache::Get(const uint64_t file_number) {
+  {
+    std::lock_guard lock(mu_);
+    const auto it = index_.find(file_number);
+    if (it != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->second;
+    }
+  }
+
+  // 打开要 mmap、读索引和过滤器，不在锁里做，别的文件的读不用等它
+  std::shared_ptr<SSTableReader> reader(Open(file_number));
+  if (reader == nullptr) {
+    LOG_ERROR("TableCache failed to open SST: " + TablePath(file_number));
+    return nullptr;
+  }
+  std::lock_guard lock(mu_);
+  // 并发打开同一个文件时用先放进去的那个
+  const auto it = index_.find(file_number);
+  if (it != index_.end()) {
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->second;
+  }
+  InsertLocked(file_number, reader);
+  return reader;
+}
+
+FileMetaData TableCache::Insert(const uint64_t file_number,
+                                SSTableReader* reader) {
+  FileMetaData meta;
+  meta.number = file_number;
+  meta.file_size = reader->FileSize();
+  meta.max_sequence = reader->MaxSequence();
+  std::lock_guard lock(mu_);
+  InsertLocked(file_number, std::shared_ptr<SSTableReader>(reader));
+  return meta;
+}
+
+void TableCache::Evict(const uint64_t file_number) {
+  std::shared_ptr<SSTableReader> reader;
+  {
+    std::lock_guard lock(mu_);
+    const auto it = index_.find(file_number);
+    if (it == index_.end()) {
+      // 没打开着的文件，它的块留在块缓存里等 LRU 淘汰
+      return;
+    }
+    reader = std::move(it->second->second);
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+  reader->EraseCachedBlocks();
+}
+
+size_t TableCache::OpenFiles() const {
+  std::lock_guard lock(mu_);
+  return lru_.size();
+}
+
+void TableCache::InsertLocked(const uint64_t file_number,
+                              std::shared_ptr<SSTableReader> reader) {
+  const auto it = index_.find(file_number);
+  if (it != index_.end()) {
+    lru_.erase(it->second);
+    index_.erase(it);
+  }
+  lru_.emplace_front(file_number, std::move(reader));
+  index_.emplace(file_number, lru_.begin());
+  while (lru_.size() > capacity_) {
+    index_.erase(lru_.back().first);
+    lru_.pop_back();
+  }
+}
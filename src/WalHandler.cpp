@@ -4,11 +4,108 @@
 
 #include "WalHandler.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <string_view>
 
+#include "Crc32c.h"
 #include "Logger.h"
 
+namespace {
+// 读出文件头里的版本号：-1 表示文件为空，0 表示没有文件头的旧格式
+int ReadFormatVersion(std::ifstream& src) {
+  char header[WalHandler::kHeaderSize];
+  if (!src.read(header, sizeof(header))) {
+    const bool empty = src.gcount() == 0;
+    src.clear();
+    src.seekg(0);
+    return empty ? -1 : 0;
+  }
+  if (std::memcmp(header, WalHandler::kMagic, WalHandler::kMagicSize) != 0) {
+    src.seekg(0);
+    return 0;
+  }
+  return static_cast<uint8_t>(header[WalHandler::kMagicSize]);
+}
+
+// 一次 read 读入的块数，整块对齐，回放时每次系统调用读 1MB
+constexpr size_t kReadBlocks = 32;
+
+// 读满 len 字节，只有到文件末尾才会返回更少
+size_t ReadFully(const int fd, char* buf, size_t len) {
+  size_t done = 0;
+  while (done < len) {
+    const ssize_t n = ::read(fd, buf + done, len - done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    done += static_cast<size_t>(n);
+  }
+  return done;
+}
+
+uint32_t LoadFixed32(const char* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+// DB 里的 WAL 以编号命名（<id>.wal），取不出编号时返回 0
+uint64_t LogNumberFromName(const std::string& filename) {
+  const std::string stem = std::filesystem::path(filename).stem().string();
+  if (stem.empty() ||
+      !std::all_of(stem.begin(), stem.end(),
+                   [](const unsigned char c) { return std::isdigit(c); })) {
+    return 0;
+  }
+  return std::stoull(stem);
+}
+
+// 解析一条逻辑记录里首尾相接的若干 Payload，
+// 直接在缓冲区上切 key/value，只在交给回调时拷贝一次
+bool ParsePayloads(std::string_view data, const bool sequenced,
+                   const WalHandler::SequencedCallback& callback) {
+  SequenceNumber sequence = 0;
+  if (sequenced) {
+    if (data.size() < WalHandler::kSequenceHeaderSize) return false;
+    std::memcpy(&sequence, data.data(), sizeof(sequence));
+    data.remove_prefix(WalHandler::kSequenceHeaderSize);
+  }
+  std::string key;
+  std::string value;
+  while (!data.empty()) {
+    if (data.size() < 1 + 4) return false;
+    const auto type = static_cast<ValueType>(data[0]);
+    const uint32_t k_len = LoadFixed32(data.data() + 1);
+    data.remove_prefix(1 + 4);
+    if (data.size() < static_cast<size_t>(k_len) + 4) return false;
+    key.assign(data.data(), k_len);
+    const uint32_t v_len = LoadFixed32(data.data() + k_len);
+    data.remove_prefix(k_len + 4);
+    if (data.size() < v_len) return false;
+    value.assign(data.data(), v_len);
+    data.remove_prefix(v_len);
+    callback(sequence, type, key, value);
+    if (sequence != 0) {
+      ++sequence;
+    }
+  }
+  return true;
+}
+}  // namespace
+
 uint32_t WalHandler::CalculateCRC32(const char* data, size_t len) {
   static const auto crc_table = []() {
     std::array<uint32_t, 256> table{};
@@ -30,56 +127,419 @@ uint32_t WalHandler::CalculateCRC32(const char* data, size_t len) {
   return crc ^ 0xFFFFFFFF;
 }
 
-WalHandler::WalHandler(const std::string& filename) : filename_(filename) {
-  // 以二进制、追加模式打开文件
-  dest_.open(filename, std::ios::binary | std::ios::app);
-  if (!dest_.is_open()) {
+WalHandler::WalHandler(const std::string& filename,
+                       const WalOpenOptions& options)
+    : filename_(filename) {
+  // 空文件名表示不落 WAL 的临时 MemTable（比如恢复时用的），什么都不打开
+  if (filename_.empty()) {
+    return;
+  }
+  // 不经过用户态缓冲，write 之后就能 fdatasync。
+  // 新文件以追加模式打开；复用的旧文件从头覆盖，不能带 O_APPEND
+  int flags = O_WRONLY | O_CREAT | O_CLOEXEC;
+  if (!options.recycle) {
+    flags |= O_APPEND;
+  }
+  fd_ = ::open(filename.c_str(), flags, 0644);
+  if (fd_ < 0) {
     LOG_ERROR(std::string("WAL open failed: ") + filename_);
+    return;
+  }
+  LOG_INFO(std::string("WAL opened: ") + filename_);
+
+  if (options.preallocate_bytes > 0) {
+    Preallocate(options.preallocate_bytes);
+  }
+
+  if (options.recycle) {
+    // 文件头推迟到第一次写入时覆盖。在那之前文件头里还是上一轮的编号，
+    // 和文件名对不上，这时崩溃回放会忽略整个文件
+    version_ = kVersionRecyclableSequenced;
+    log_number_ = options.log_number;
+    header_pending_ = true;
+    block_offset_ = kRecyclableHeaderSize;
+    return;
+  }
+
+  // 往已有文件后面追加时沿用它的格式，同一个文件里不混用两种格式
+  std::ifstream src(filename_, std::ios::binary);
+  const int version = ReadFormatVersion(src);
+  header_pending_ = version < 0;
+  if (header_pending_) {
+    version_ = options.log_number != 0 ? kVersionRecyclableSequenced
+                                       : kVersionSequenced;
+    log_number_ = options.log_number;
   } else {
-    LOG_INFO(std::string("WAL opened: ") + filename_);
+    version_ = version;
+    if (Recyclable()) {
+      src.read(reinterpret_cast<char*>(&log_number_), sizeof(log_number_));
+    }
+  }
+  if (version_ >= kVersionBlock) {
+    struct stat st {};
+    const size_t file_size = ::fstat(fd_, &st) == 0 ? st.st_size : 0;
+    // 新文件的文件头占第 0 块开头
+    block_offset_ =
+        header_pending_ ? FileHeaderSize() : file_size % kBlockSize;
+  }
+}
+
+void WalHandler::Preallocate(const size_t bytes) {
+#if defined(__linux__)
+  // KEEP_SIZE 只分配磁盘块不改文件长度，回放仍然读到真实的文件末尾
+  if (::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(bytes)) !=
+      0) {
+    LOG_WARN(std::string("WAL preallocate failed: ") + filename_ + ": " +
+             std::strerror(errno));
   }
+#else
+  (void)bytes;
+#endif
 }
 
 WalHandler::~WalHandler() {
-  if (dest_.is_open()) {
-    dest_.close();
+  if (fd_ >= 0) {
+    // 关闭前按策略补一次同步，kNone 交给内核自己回写
+    if (sync_mode_ != WalSyncMode::kNone) {
+      Sync();
+    }
+    ::close(fd_);
     LOG_INFO(std::string("WAL closed: ") + filename_);
   }
 }
 
 std::string WalHandler::GetFilename() const { return filename_; }
 
-void WalHandler::AddLog(const std::string& key, const std::string& value,
+bool WalHandler::AddLog(const std::string& key, const std::string& value,
                         ValueType type) {
-  // 1. 拼凑整个 Body 内容
-  std::string payload;
+  std::string record;
+  BeginBatch(&record, 0);
+  EncodeRecord(&record, key, value, type);
+  return AddRecords(record);
+}
+
+void WalHandler::BeginBatch(std::string* dst,
+                            const SequenceNumber first_sequence) const {
+  if (Sequenced()) {
+    dst->append(reinterpret_cast<const char*>(&first_sequence),
+                sizeof(first_sequence));
+  }
+}
+
+void WalHandler::EncodeRecord(std::string* dst, const std::string& key,
+                              const std::string& value,
+                              ValueType type) const {
+  // 1. 旧格式先给 CRC 占位，再把 Payload 直接拼在 dst 后面
   uint8_t t = static_cast<uint8_t>(type);
   uint32_t k_len = key.size();
   uint32_t v_len = value.size();
 
-  // 预分配空间，减少扩容开销
-  payload.reserve(1 + 4 + k_len + 4 + v_len);
+  const bool framed = version_ >= kVersionBlock;
+  const size_t crc_pos = dst->size();
+  if (!framed) {
+    dst->append(4, '\0');
+  }
+  const size_t body_pos = dst->size();
+  dst->append(reinterpret_cast<char*>(&t), 1);
+  dst->append(reinterpret_cast<char*>(&k_len), 4);
+  dst->append(key);
+  dst->append(reinterpret_cast<char*>(&v_len), 4);
+  dst->append(value);
+  if (framed) {
+    return;  // 校验和由 AddRecords 分片时按物理记录计算
+  }
+
+  // 2. 计算 Checksum 并回填：[CRC (4B)] + [Payload]
+  const char* body = dst->data() + body_pos;
+  const size_t body_len = dst->size() - body_pos;
+  uint32_t crc = version_ == kVersionCrc32c ? crc32c::Value(body, body_len)
+                                            : CalculateCRC32(body, body_len);
+  std::memcpy(&(*dst)[crc_pos], &crc, 4);
+}
+
+void WalHandler::AppendFragments(std::string* dst, const char* data,
+                                 size_t len) {
+  const size_t header_size = FragmentHeaderSize();
+  const auto log_number = static_cast<uint32_t>(log_number_);
+  bool begin = true;
+  do {
+    const size_t leftover = kBlockSize - block_offset_;
+    if (leftover < header_size) {
+      // 块尾放不下一个物理记录头，补零后换到下一块
+      dst->append(leftover, '\0');
+      block_offset_ = 0;
+    }
+    const size_t avail = kBlockSize - block_offset_ - header_size;
+    const size_t fragment = std::min(len, avail);
+    const bool end = fragment == len;
+    const FragmentType type = begin && end ? kFullType
+                              : begin      ? kFirstType
+                              : end        ? kLastType
+                                           : kMiddleType;
+
+    const auto type_byte = static_cast<char>(type);
+    uint32_t crc = crc32c::Value(&type_byte, 1);
+    if (Recyclable()) {
+      crc = crc32c::Extend(crc, reinterpret_cast<const char*>(&log_number), 4);
+    }
+    crc = crc32c::Extend(crc, data, fragment);
+    const auto length = static_cast<uint16_t>(fragment);
+    dst->append(reinterpret_cast<const char*>(&crc), 4);
+    dst->append(reinterpret_cast<const char*>(&length), 2);
+    dst->push_back(type_byte);
+    if (Recyclable()) {
+      dst->append(reinterpret_cast<const char*>(&log_number), 4);
+    }
+    dst->append(data, fragment);
 
-  payload.append(reinterpret_cast<char*>(&t), 1);
-  payload.append(reinterpret_cast<char*>(&k_len), 4);
-  payload.append(key);
-  payload.append(reinterpret_cast<char*>(&v_len), 4);
-  payload.append(value);
+    block_offset_ += header_size + fragment;
+    data += fragment;
+    len -= fragment;
+    begin = false;
+  } while (len > 0);
+}
 
-  // 2. 计算 Checksum
-  uint32_t crc = CalculateCRC32(payload.c_str(), payload.size());
+bool WalHandler::AddRecords(const std::string& encoded, const bool sync) {
+  // 不落 WAL 的临时 MemTable
+  if (filename_.empty()) {
+    return true;
+  }
+  if (Failed()) {
+    return false;
+  }
+  // 文件头、补零和各个分片拼进同一个缓冲区，一次 write 写完
+  std::string framed;
+  const std::string* out = &encoded;
+  if (header_pending_ || version_ >= kVersionBlock) {
+    framed.reserve(FileHeaderSize() + encoded.size() +
+                   (encoded.size() / kBlockSize + 2) * FragmentHeaderSize());
+    if (header_pending_) {
+      framed.append(kMagic, kMagicSize);
+      framed.push_back(static_cast<char>(version_));
+      if (Recyclable()) {
+        framed.append(reinterpret_cast<const char*>(&log_number_),
+                      sizeof(log_number_));
+      }
+    }
+    if (version_ >= kVersionBlock) {
+      AppendFragments(&framed, encoded.data(), encoded.size());
+    } else {
+      framed.append(encoded);
+    }
+    out = &framed;
+  }
+  if (!WriteAll(out->data(), out->size())) {
+    LOG_ERROR(std::string("WAL write failed: ") + filename_ + ": " +
+              std::strerror(errno));
+    // 可能已经写进去半条，块内偏移也已经前移，后面再写回放时也读不到
+    failed_.store(true, std::memory_order_release);
+    return false;
+  }
+  header_pending_ = false;
+  const size_t unsynced =
+      unsynced_bytes_.fetch_add(out->size(), std::memory_order_relaxed) +
+      out->size();
+  if (sync || sync_mode_ == WalSyncMode::kEveryWrite ||
+      (sync_mode_ == WalSyncMode::kPeriodic && bytes_per_sync_ > 0 &&
+       unsynced >= bytes_per_sync_)) {
+    // 不能走 Sync() 的计数捷径：计数可能刚被后台线程清零而它的 fdatasync
+    // 还没完成，要求同步的写入必须自己同步完才能返回
+    unsynced_bytes_.store(0, std::memory_order_relaxed);
+    return DataSync();
+  }
+  return true;
+}
+
+void WalHandler::SetSyncPolicy(const WalSyncMode mode,
+                               const size_t bytes_per_sync) {
+  sync_mode_ = mode;
+  bytes_per_sync_ = bytes_per_sync;
+}
+
+bool WalHandler::Sync() {
+  if (Failed()) {
+    return false;
+  }
+  // 先清零再同步：同步期间新写入的字节会重新累计，留给下一次
+  if (fd_ < 0 || unsynced_bytes_.exchange(0, std::memory_order_relaxed) == 0) {
+    return true;
+  }
+  return DataSync();
+}
+
+bool WalHandler::DataSync() {
+  if (::fdatasync(fd_) != 0) {
+    LOG_ERROR(std::string("WAL fdatasync failed: ") + filename_ + ": " +
+              std::strerror(errno));
+    // fdatasync 失败后内核可能已经丢掉了脏页，再同步一次成功也不代表数据在盘上
+    failed_.store(true, std::memory_order_release);
+    return false;
+  }
+  sync_count_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
 
-  // 3. 一次性写入：[CRC (4B)] + [Payload]
-  dest_.write(reinterpret_cast<char*>(&crc), 4);
-  dest_.write(payload.data(), payload.size());
-  dest_.flush();
+bool WalHandler::WriteAll(const char* data, size_t len) {
+  if (fd_ < 0) {
+    return false;
+  }
+  while (len > 0) {
+    const ssize_t n = ::write(fd_, data, len);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += n;
+    len -= static_cast<size_t>(n);
+  }
+  return true;
 }
 
 void WalHandler::LoadLog(
     std::function<void(ValueType, const std::string&, const std::string&)>
         callback) {
+  LoadLogWithSequence([&callback](SequenceNumber, const ValueType type,
+                                  const std::string& key,
+                                  const std::string& value) {
+    callback(type, key, value);
+  });
+}
+
+void WalHandler::LoadLogWithSequence(const SequencedCallback& callback) {
   std::ifstream src(filename_, std::ios::binary);
   if (!src.is_open()) return;
+  const int version = ReadFormatVersion(src);
+  const bool sequenced = version >= kVersionSequenced;
+  if (version > kVersionRecyclableSequenced) {
+    LOG_ERROR(std::string("WAL format version not supported: ") + filename_);
+    return;
+  }
+  if (IsRecyclable(version)) {
+    uint64_t log_number = 0;
+    if (!src.read(reinterpret_cast<char*>(&log_number), sizeof(log_number))) {
+      return;
+    }
+    // 复用的文件改名后还没来得及写入新文件头，里面全是上一轮的数据
+    const uint64_t name_number = LogNumberFromName(filename_);
+    if (name_number != 0 && name_number != log_number) {
+      LOG_INFO(std::string("Recycled WAL not written yet, skip: ") +
+               filename_);
+      return;
+    }
+    src.close();
+    LoadBlockLog(log_number, sequenced, callback);
+    return;
+  }
+  if (version >= kVersionBlock) {
+    src.close();
+    LoadBlockLog(0, sequenced, callback);
+    return;
+  }
+  LoadUnframedLog(src, version == kVersionCrc32c, callback);
+}
+
+void WalHandler::LoadBlockLog(const uint64_t expected_log,
+                              const bool sequenced,
+                              const SequencedCallback& callback) {
+  const bool recyclable = expected_log != 0;
+  const size_t header_size =
+      recyclable ? kRecyclableFragmentHeaderSize : kFragmentHeaderSize;
+  const auto log_number = static_cast<uint32_t>(expected_log);
+  const int fd = ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+
+  std::string buffer(kReadBlocks * kBlockSize, '\0');
+  // 跨块的逻辑记录在这里拼起来；整条落在一块里的直接在 buffer 上解析
+  std::string scratch;
+  bool in_fragmented = false;
+  bool first_block = true;
+  bool ok = true;
+
+  while (ok) {
+    const size_t n = ReadFully(fd, buffer.data(), buffer.size());
+    if (n == 0) break;
+
+    for (size_t block = 0; ok && block < n; block += kBlockSize) {
+      const char* base = buffer.data() + block;
+      const size_t block_len = std::min(kBlockSize, n - block);
+      size_t pos = first_block
+                       ? (recyclable ? kRecyclableHeaderSize : kHeaderSize)
+                       : 0;
+      first_block = false;
+
+      while (block_len - pos >= header_size) {
+        const char* header = base + pos;
+        uint16_t length;
+        std::memcpy(&length, header + 4, 2);
+        const auto type = static_cast<uint8_t>(header[6]);
+        if (type == kZeroType && length == 0) {
+          break;  // 块尾补零
+        }
+        if (pos + header_size + length > block_len) {
+          // 物理记录被截断：崩溃时最后一次写入只写了一半
+          ok = false;
+          break;
+        }
+        if (recyclable && LoadFixed32(header + 7) != log_number) {
+          // 复用文件里上一轮留下的残尾，本轮的记录到此为止
+          ok = false;
+          break;
+        }
+        const char* data = header + header_size;
+        uint32_t crc = crc32c::Value(header + 6, 1);
+        if (recyclable) {
+          crc = crc32c::Extend(crc, header + 7, 4);
+        }
+        if (crc32c::Extend(crc, data, length) != LoadFixed32(header)) {
+          if (recyclable) {
+            // 残尾也可能来自更早格式的文件，编号字段恰好对上的概率很小
+            LOG_WARN("WAL checksum mismatch, ignore the rest of the file.");
+          } else {
+            LOG_ERROR("WAL checksum mismatch: data might be corrupted.");
+          }
+          ok = false;
+          break;
+        }
+        pos += header_size + length;
+
+        switch (type) {
+          case kFullType:
+            ok = !in_fragmented &&
+                 ParsePayloads({data, length}, sequenced, callback);
+            break;
+          case kFirstType:
+            ok = !in_fragmented;
+            scratch.assign(data, length);
+            in_fragmented = true;
+            break;
+          case kMiddleType:
+            ok = in_fragmented;
+            scratch.append(data, length);
+            break;
+          case kLastType:
+            ok = in_fragmented;
+            scratch.append(data, length);
+            in_fragmented = false;
+            ok = ok && ParsePayloads(scratch, sequenced, callback);
+            break;
+          default:
+            ok = false;
+            break;
+        }
+        if (!ok) {
+          LOG_ERROR("WAL record malformed: data might be corrupted.");
+        }
+      }
+    }
+    if (n < buffer.size()) break;  // 已经读到文件末尾
+  }
+  ::close(fd);
+}
+
+void WalHandler::LoadUnframedLog(std::ifstream& src, const bool use_crc32c,
+                                 const SequencedCallback& callback) {
   while (src.peek() != EOF) {
     // 1. 读取 Checksum
     uint32_t saved_crc;
@@ -109,13 +569,16 @@ void WalHandler::LoadLog(
     body.append(reinterpret_cast<char*>(&v_len), 4);
     body.append(value);
 
-    if (CalculateCRC32(body.data(), body.size()) != saved_crc) {
+    const uint32_t crc = use_crc32c
+                             ? crc32c::Value(body.data(), body.size())
+                             : CalculateCRC32(body.data(), body.size());
+    if (crc != saved_crc) {
       LOG_ERROR("WAL checksum mismatch: data might be corrupted.");
       break;  // 或者跳过这条记录
     }
 
     // 4. 通过回调函数，把恢复出来的 KV 交给 MemTable 处理
-    callback(static_cast<ValueType>(t), key, value);
+    callback(0, static_cast<ValueType>(t), key, value);
   }
   src.close();
 }
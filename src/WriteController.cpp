@@ -0,0 +1,83 @@
+//
+// Created by 26708 on 2026/3/25.
+//
+
+#include "WriteController.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// 积压到顶时速率最低降到 max_rate 的几分之一，不会降成 0
+constexpr uint64_t kMinRateDivisor = 16;
+// 桶里最多攒 10ms 的令牌：空闲之后的一小段突发不用等，但攒不出长时间的高速
+constexpr uint64_t kBurstMicros = 10000;
+
+}  // namespace
+
+WriteController::WriteController(const uint64_t max_rate)
+    : max_rate_(std::max<uint64_t>(max_rate, 1)) {}
+
+void WriteController::SetCondition(const WriteStallCondition condition,
+                                   const double pressure) {
+  std::lock_guard lock(mu_);
+  const uint64_t now = NowMicros();
+  if (condition != WriteStallCondition::kDelayed) {
+    condition_ = condition;
+    rate_ = 0;
+    return;
+  }
+  if (condition_ == WriteStallCondition::kDelayed) {
+    // 先按旧速率结算已经流逝的时间，再换速率
+    RefillLocked(now);
+  } else {
+    // 刚进入限速：桶是空的，之前不限速时的写入不欠账
+    available_ = 0;
+    last_refill_micros_ = now;
+  }
+  condition_ = condition;
+  const double p = std::clamp(pressure, 0.0, 1.0);
+  const auto min_rate = std::max<uint64_t>(max_rate_ / kMinRateDivisor, 1);
+  rate_ = std::max(min_rate, static_cast<uint64_t>(max_rate_ * (1.0 - p)));
+}
+
+WriteStallCondition WriteController::condition() const {
+  std::lock_guard lock(mu_);
+  return condition_;
+}
+
+uint64_t WriteController::delayed_write_rate() const {
+  std::lock_guard lock(mu_);
+  return rate_;
+}
+
+uint64_t WriteController::GetDelay(const uint64_t bytes) {
+  std::lock_guard lock(mu_);
+  if (condition_ != WriteStallCondition::kDelayed) {
+    return 0;
+  }
+  RefillLocked(NowMicros());
+  available_ -= static_cast<double>(bytes);
+  if (available_ >= 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(-available_ * 1e6 / static_cast<double>(rate_));
+}
+
+void WriteController::RefillLocked(const uint64_t now_micros) {
+  if (now_micros <= last_refill_micros_) {
+    return;
+  }
+  available_ += static_cast<double>(now_micros - last_refill_micros_) *
+                static_cast<double>(rate_) / 1e6;
+  available_ = std::min(
+      available_, static_cast<double>(rate_) * kBurstMicros / 1e6);
+  last_refill_micros_ = now_micros;
+}
+
+uint64_t WriteController::NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
@@ -44,6 +44,14 @@ void CommandExecutor::Execute(const std::vector<std::string>& command,
     HandleRScan(command, response_buffer);
     return;
   }
+  if (cmd == "MSET") {
+    HandleMSet(command, response_buffer);
+    return;
+  }
+  if (cmd == "MDEL") {
+    HandleMDel(command, response_buffer);
+    return;
+  }
 
   LOG_WARN("unknown command '" + command[0] + "'");
   RESPEncoder::EncodeError(response_buffer,
@@ -63,7 +71,10 @@ void CommandExecutor::HandleSet(const std::vector<std::string>& command,
   record.type = ValueType::kValue;
   record.value = value;
 
-  db_->Put(key, record);
+  if (!db_->Put(key, record)) {
+    RESPEncoder::EncodeError(response_buffer, "write failed");
+    return;
+  }
 
   RESPEncoder::EncodeSimpleString(response_buffer, "OK");
 }
@@ -76,18 +87,16 @@ void CommandExecutor::HandleGet(const std::vector<std::string>& command,
 
   const std::string& key = command[1];
 
-  ValueRecord record;
-  record.type = ValueType::kValue;
-  record.value = "";
-
-  const bool found = db_->Get(key, record);
+  // value 直接从 MemTable / mmap 编码进响应缓冲，中间不拷贝
+  PinnedValue value;
+  const bool found = db_->Get(key, &value);
 
   if (!found) {
     RESPEncoder::EncodeNull(response_buffer);
     return;
   }
 
-  RESPEncoder::EncodeBulkString(response_buffer, record.value);
+  RESPEncoder::EncodeBulkString(response_buffer, value.value());
 }
 
 void CommandExecutor::HandleDel(const std::vector<std::string>& command,
@@ -102,7 +111,10 @@ void CommandExecutor::HandleDel(const std::vector<std::string>& command,
   record.type = ValueType::kDeletion;
   record.value = "";
 
-  db_->Put(key, record);
+  if (!db_->Put(key, record)) {
+    RESPEncoder::EncodeError(response_buffer, "write failed");
+    return;
+  }
 
   RESPEncoder::EncodeSimpleString(response_buffer, "OK");
 }
@@ -115,9 +127,12 @@ void CommandExecutor::HandleRScan(const std::vector<std::string>& command,
 
   const std::string& start_key = command[1];
 
-  const auto iter = db_->NewIterator();
-
-  iter->Seek(start_key);
+  // 直接从 start_key 开始收集，MemTable 里起点之前的数据不再整体拷贝
+  const auto iter = db_->NewIterator(start_key);
+  if (iter == nullptr) {
+    RESPEncoder::EncodeError(response_buffer, "failed to read SST");
+    return;
+  }
 
   std::vector<std::string> elements;
 
@@ -130,6 +145,47 @@ void CommandExecutor::HandleRScan(const std::vector<std::string>& command,
   RESPEncoder::EncodeArray(response_buffer, elements);
 }
 
+void CommandExecutor::HandleMSet(const std::vector<std::string>& command,
+                                 NetworkBuffer* response_buffer) const {
+  // MSET key value [key value ...]
+  if (command.size() < 3 || command.size() % 2 == 0) {
+    ReplyWrongArgCount(command, response_buffer);
+    return;
+  }
+
+  // 整条命令打成一个 WriteBatch：一次加锁、一次 WAL 写，且全部生效或全部不生效
+  WriteBatch batch;
+  for (size_t i = 1; i < command.size(); i += 2) {
+    batch.Put(command[i], command[i + 1]);
+  }
+  if (!db_->Write(batch)) {
+    RESPEncoder::EncodeError(response_buffer, "write failed");
+    return;
+  }
+
+  RESPEncoder::EncodeSimpleString(response_buffer, "OK");
+}
+
+void CommandExecutor::HandleMDel(const std::vector<std::string>& command,
+                                 NetworkBuffer* response_buffer) const {
+  // MDEL key [key ...]，和 DEL 一样不区分 key 原本是否存在
+  if (command.size() < 2) {
+    ReplyWrongArgCount(command, response_buffer);
+    return;
+  }
+
+  WriteBatch batch;
+  for (size_t i = 1; i < command.size(); ++i) {
+    batch.Delete(command[i]);
+  }
+  if (!db_->Write(batch)) {
+    RESPEncoder::EncodeError(response_buffer, "write failed");
+    return;
+  }
+
+  RESPEncoder::EncodeSimpleString(response_buffer, "OK");
+}
+
 std::string CommandExecutor::NormalizeCommandName(
     const std::string& command_name) {
   std::string result = command_name;  // 创建副本
@@ -155,3 +211,12 @@ bool CommandExecutor::ExpectArgCount(const std::vector<std::string>& command,
       response_buffer, "wrong number of arguments for '" + cmd + "' command");
   return false;
 }
+
+void CommandExecutor::ReplyWrongArgCount(
+    const std::vector<std::string>& command, NetworkBuffer* response_buffer) {
+  const std::string cmd = NormalizeCommandName(command[0]);
+  LOG_WARN("wrong number of arguments for '" + cmd + "' command: got " +
+           std::to_string(command.size()));
+  RESPEncoder::EncodeError(
+      response_buffer, "wrong number of arguments for '" + cmd + "' command");
+}
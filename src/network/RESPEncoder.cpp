@@ -25,7 +25,7 @@ void RESPEncoder::EncodeInteger(NetworkBuffer* buffer, const int64_t val) {
 }
 
 void RESPEncoder::EncodeBulkString(NetworkBuffer* buffer,
-                                   const std::string& str) {
+                                   const std::string_view str) {
   const std::string len_str = std::to_string(str.size());
   buffer->Append("$", 1);
   buffer->Append(len_str.data(), len_str.size());
@@ -0,0 +1,48 @@
+#include "Arena.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Test Intent: 验证 Arena 分配出的内存互不重叠、对齐满足节点要求，
+// 且 MemoryUsage 随分配单调增长（MemTable 的内存统计依赖这一点）。
+TEST(ArenaTest, EmptyArenaHasNoUsage) {
+  Arena arena;
+  EXPECT_EQ(arena.MemoryUsage(), 0u);
+}
+
+TEST(ArenaTest, AllocationsDoNotOverlap) {
+  Arena arena;
+  std::vector<std::pair<char*, size_t>> allocated;
+  size_t last_usage = 0;
+  for (size_t i = 0; i < 2000; ++i) {
+    // 混合小对象与超过块大小 1/4 的大对象
+    const size_t bytes = (i % 50 == 0) ? 5000 + i : 1 + (i % 97);
+    char* p =
+        (i % 2 == 0) ? arena.Allocate(bytes) : arena.AllocateAligned(bytes);
+    std::memset(p, static_cast<int>(i % 256), bytes);
+    allocated.emplace_back(p, bytes);
+
+    EXPECT_GE(arena.MemoryUsage(), last_usage);
+    last_usage = arena.MemoryUsage();
+  }
+
+  for (size_t i = 0; i < allocated.size(); ++i) {
+    const auto& [p, bytes] = allocated[i];
+    for (size_t b = 0; b < bytes; ++b) {
+      ASSERT_EQ(static_cast<unsigned char>(p[b]), i % 256);
+    }
+  }
+}
+
+TEST(ArenaTest, AlignedAllocationIsPointerAligned) {
+  Arena arena;
+  arena.Allocate(3);  // 故意把游标推到非对齐位置
+  for (int i = 0; i < 100; ++i) {
+    char* p = arena.AllocateAligned(24);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % sizeof(void*), 0u);
+    arena.Allocate(1);
+  }
+}
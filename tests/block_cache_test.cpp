@@ -0,0 +1,90 @@
+#include "BlockCache.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "BlockBuilder.h"
+
+namespace {
+
+// 一个大约 bytes 字节的块，只有一条记录
+std::shared_ptr<const Block> MakeBlock(const std::string& key,
+                                       const size_t bytes) {
+  BlockBuilder builder;
+  builder.Add(key, std::string(bytes, 'v'), ValueType::kValue);
+  const std::string data = builder.Finish();
+  return Block::Copy(data.data(), data.size(), false,
+                     BlockFormat::kPrefixCompressed);
+}
+
+}  // namespace
+
+// Test Intent: 验证块缓存按 (文件号, 偏移) 命中、超出容量时先淘汰最久没用的块，
+// 被淘汰的块对持有它的读者仍然有效，命中/未命中计数准确。
+TEST(BlockCacheTest, LookupHitsAndMisses) {
+  BlockCache cache(1024 * 1024);
+  EXPECT_EQ(cache.Lookup(1, 0), nullptr);
+
+  const auto block = MakeBlock("k", 100);
+  cache.Insert(1, 0, block);
+  EXPECT_EQ(cache.Lookup(1, 0), block);
+  // 同一偏移、不同文件是不同的块
+  EXPECT_EQ(cache.Lookup(2, 0), nullptr);
+
+  EXPECT_EQ(cache.Hits(), 1u);
+  EXPECT_EQ(cache.Misses(), 2u);
+  EXPECT_EQ(cache.Usage(), block->Charge());
+
+  cache.Erase(1, 0);
+  EXPECT_EQ(cache.Lookup(1, 0), nullptr);
+  EXPECT_EQ(cache.Usage(), 0u);
+}
+
+TEST(BlockCacheTest, EvictsLeastRecentlyUsed) {
+  // 容量小于 1MB 时只有一个分片，淘汰顺序就是全局 LRU
+  const size_t block_bytes = 4096;
+  const size_t charge = MakeBlock("k", block_bytes)->Charge();
+  BlockCache cache(charge * 3);
+
+  cache.Insert(1, 0, MakeBlock("a", block_bytes));
+  cache.Insert(1, 4096, MakeBlock("b", block_bytes));
+  cache.Insert(1, 8192, MakeBlock("c", block_bytes));
+  // 用一下最旧的 a，下一次淘汰的就是 b
+  const auto pinned = cache.Lookup(1, 0);
+  ASSERT_NE(pinned, nullptr);
+  cache.Insert(1, 12288, MakeBlock("d", block_bytes));
+
+  EXPECT_NE(cache.Lookup(1, 0), nullptr);
+  EXPECT_EQ(cache.Lookup(1, 4096), nullptr);
+  EXPECT_NE(cache.Lookup(1, 8192), nullptr);
+  EXPECT_NE(cache.Lookup(1, 12288), nullptr);
+  EXPECT_LE(cache.Usage(), cache.Capacity());
+
+  // 挤掉之后，之前拿到的块照样能读
+  cache.Insert(1, 16384, MakeBlock("e", block_bytes));
+  cache.Insert(1, 20480, MakeBlock("f", block_bytes));
+  cache.Insert(1, 24576, MakeBlock("g", block_bytes));
+  EXPECT_EQ(cache.Lookup(1, 0), nullptr);
+  Block::Iter it(pinned.get());
+  it.SeekToFirst();
+  ASSERT_TRUE(it.Valid());
+  EXPECT_EQ(it.entry().key, "a");
+  EXPECT_EQ(it.entry().value.size(), block_bytes);
+}
+
+TEST(BlockCacheTest, ShardedCacheStaysWithinCapacity) {
+  const size_t capacity = 4 * 1024 * 1024;
+  BlockCache cache(capacity);
+  for (uint64_t i = 0; i < 4096; ++i) {
+    cache.Insert(i % 7, i * 4096, MakeBlock("k" + std::to_string(i), 4000));
+  }
+  EXPECT_LE(cache.Usage(), capacity);
+  // 各分片都装得差不多满
+  EXPECT_GT(cache.Usage(), capacity / 2);
+
+  // 比分片容量还大的块不缓存
+  cache.Insert(100, 0, MakeBlock("huge", capacity));
+  EXPECT_EQ(cache.Lookup(100, 0), nullptr);
+}
@@ -3,6 +3,10 @@
 //
 
 #include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Block.h"
 #include "BlockBuilder.h"
 
 class BlockBuilderTest : public ::testing::Test {
@@ -26,43 +30,214 @@ TEST_F(BlockBuilderTest, EmptyInitially) {
     EXPECT_EQ(builder_->CurrentSizeEstimate(), 0);
 }
 
-// 测试 2：验证单条记录写入后的长度计算
-// 布局：KeyLen(4) + "key1"(4) + ValueType(1) + ValLen(4) + "value1"(6) = 19 字节
-TEST_F(BlockBuilderTest, AddSingleEntry) {
-    builder_->Add("key1", "value1", ValueType::kValue);
-
-    EXPECT_FALSE(builder_->Empty());
-    // 4 + 4 + 1 + 4 + 6 = 19
-    EXPECT_EQ(builder_->CurrentSizeEstimate(), 19);
-}
+// 测试 2：验证单条记录写入后的长度计算
+// 布局：Shared(1) + NonShared(1) + ValLen(1) + ValueType(1) + "key1"(4)
+// + "value1"(6) = 14 字节，再加上重启点数组：一个重启点(4) + 重启点个数(4)
+TEST_F(BlockBuilderTest, AddSingleEntry) {
+    builder_->Add("key1", "value1", ValueType::kValue);
+
+    EXPECT_FALSE(builder_->Empty());
+    // 1 + 1 + 1 + 1 + 4 + 6 + 4 + 4 = 22
+    EXPECT_EQ(builder_->CurrentSizeEstimate(), 22);
+}
 
 // 测试 3 : 验证多条记录连续写入
-TEST_F(BlockBuilderTest, AddMultipleEntries) {
-    builder_->Add("k1", "v1", ValueType::kValue); // 4+2 + 1 + 4+2 = 13
-    builder_->Add("k2", "v2", ValueType::kValue); // 13 + 13 = 26
-
-    EXPECT_EQ(builder_->CurrentSizeEstimate(), 26);
-}
+TEST_F(BlockBuilderTest, AddMultipleEntries) {
+    builder_->Add("k1", "v1", ValueType::kValue); // 3 + 1 + 2 + 2 = 8
+    builder_->Add("k2", "v2", ValueType::kValue); // 和上一条共享 "k"：3 + 1 + 1 + 2 = 7
+
+    // 两条都在第一个重启点之后：15 + 4 + 4 = 23
+    EXPECT_EQ(builder_->CurrentSizeEstimate(), 23);
+}
 
 // 测试 4：验证 Reset 功能是否清空数据
-TEST_F(BlockBuilderTest, ResetLogic) {
-    builder_->Add("test", "data", ValueType::kValue);
-    builder_->Reset();
+TEST_F(BlockBuilderTest, ResetLogic) {
+    builder_->Add("test", "data", ValueType::kValue);
+    builder_->Reset();
 
     EXPECT_TRUE(builder_->Empty());
     EXPECT_EQ(builder_->CurrentSizeEstimate(), 0);
 }
 
 // 测试 5：验证 Finish 后的数据完整性（可选，简单校验）
-TEST_F(BlockBuilderTest, FinishReturnsData) {
-    std::string k = "hi";
-    std::string v = "world";
-    builder_->Add(k, v, ValueType::kValue);
-
-    std::string result = builder_->Finish();
-    EXPECT_EQ(result.size(), 4 + 2 + 1 + 4 + 5);
-    // 验证前 4 个字节是否记录了长度 2
-    uint32_t len;
-    memcpy(&len, result.data(), sizeof(uint32_t));
-    EXPECT_EQ(len, 2);
-}
+TEST_F(BlockBuilderTest, FinishReturnsData) {
+    std::string k = "hi";
+    std::string v = "world";
+    builder_->Add(k, v, ValueType::kValue);
+
+    std::string result = builder_->Finish();
+    EXPECT_EQ(result.size(), 3 + 1 + 2 + 5 + 4 + 4);
+    // 第一条是重启点：共享 0 字节，非共享部分就是完整的 key
+    EXPECT_EQ(result[0], 0);
+    EXPECT_EQ(result[1], 2);
+    EXPECT_EQ(result[2], 5);
+    EXPECT_EQ(result.substr(4, 2), "hi");
+    // 末尾是重启点个数 1，唯一的重启点指向第一条记录
+    uint32_t num_restarts;
+    memcpy(&num_restarts, result.data() + result.size() - 4, sizeof(uint32_t));
+    EXPECT_EQ(num_restarts, 1);
+    uint32_t restart;
+    memcpy(&restart, result.data() + result.size() - 8, sizeof(uint32_t));
+    EXPECT_EQ(restart, 0);
+}
+
+// 测试 6：每 restart_interval 条记录放一个重启点
+TEST(BlockRestartTest, RestartPointEveryInterval) {
+    BlockBuilder builder(4);
+    for (int i = 0; i < 10; ++i) {
+        builder.Add("k" + std::to_string(i), "v", ValueType::kValue);
+    }
+    const std::string result = builder.Finish();
+
+    uint32_t num_restarts;
+    memcpy(&num_restarts, result.data() + result.size() - 4, sizeof(uint32_t));
+    ASSERT_EQ(num_restarts, 3);
+    // 重启点上的记录存完整的 key，3 + 1 + 2 + 1 = 7 字节；其余记录和上一条
+    // 共享 "k"，3 + 1 + 1 + 1 = 6 字节。重启点在第 0、4、8 条
+    const char* restarts = result.data() + result.size() - 4 * (3 + 1);
+    for (uint32_t i = 0; i < 3; ++i) {
+        uint32_t offset;
+        memcpy(&offset, restarts + 4 * i, sizeof(uint32_t));
+        EXPECT_EQ(offset, i * (7 + 3 * 6));
+        EXPECT_EQ(result[offset], 0);
+    }
+}
+
+// 测试 7：Block 读路径按重启点二分定位，同一个 key 的版本跨过重启点时
+// 也从最新的那一版开始
+TEST(BlockRestartTest, SeekUsesRestartPoints) {
+    BlockBuilder builder(4);
+    auto add = [&builder](const std::string& key, uint64_t sequence) {
+        std::string internal_key = key;
+        internal_key.append(reinterpret_cast<const char*>(&sequence),
+                            sizeof(sequence));
+        builder.Add(internal_key, "v" + std::to_string(sequence),
+                    ValueType::kValue);
+    };
+    for (int i = 0; i < 50; ++i) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "key_%03d", i * 2);
+        add(buf, 100 + i);
+    }
+    // key_100 有 9 个版本，从新到旧，横跨好几个重启点
+    for (uint64_t s = 30; s > 21; --s) {
+        add("key_100", s);
+    }
+    add("key_102", 1);
+    const std::string data = builder.Finish();
+    const Block block(data.data(), data.size(), true,
+                      BlockFormat::kPrefixCompressed);
+
+    Block::Iter it(&block);
+    it.Seek("key_040");
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.entry().key, "key_040");
+    EXPECT_EQ(it.entry().sequence, 120u);
+
+    // 不存在的 key 停在下一个更大的 key 上
+    it.Seek("key_041");
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.entry().key, "key_042");
+
+    it.Seek("key_100");
+    for (uint64_t s = 30; s > 21; --s) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.entry().key, "key_100");
+        EXPECT_EQ(it.entry().sequence, s);
+        it.Next();
+    }
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.entry().key, "key_102");
+
+    it.Seek("key_000");
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.entry().sequence, 100u);
+    it.Seek("zzz");
+    EXPECT_FALSE(it.Valid());
+
+    int count = 0;
+    for (it.SeekToFirst(); it.Valid(); it.Next()) {
+        ++count;
+    }
+    EXPECT_EQ(count, 60);
+}
+
+// 按旧的定长格式拼一条记录：[KeyLen (4B)][Key][ValueType][ValLen (4B)][Value]
+void AppendPlainEntry(std::string* dst, const std::string& key,
+                      const std::string& value, ValueType type) {
+    const auto key_len = static_cast<uint32_t>(key.size());
+    const auto val_len = static_cast<uint32_t>(value.size());
+    dst->append(reinterpret_cast<const char*>(&key_len), sizeof(key_len));
+    dst->append(key);
+    dst->push_back(static_cast<char>(type));
+    dst->append(reinterpret_cast<const char*>(&val_len), sizeof(val_len));
+    dst->append(value);
+}
+
+// 测试 8：旧文件里的定长格式块照样能读，没有重启点数组的只能从头扫
+TEST(BlockRestartTest, LegacyBlockWithoutRestarts) {
+    std::string data;
+    AppendPlainEntry(&data, "a", "1", ValueType::kValue);
+    AppendPlainEntry(&data, "b", "2", ValueType::kDeletion);
+    AppendPlainEntry(&data, "c", "3", ValueType::kValue);
+
+    const Block plain(data.data(), data.size(), false, BlockFormat::kPlain);
+    // 加上只有一个重启点的数组就是 kRestarts 格式
+    const uint32_t trailer[2] = {0, 1};
+    data.append(reinterpret_cast<const char*>(trailer), sizeof(trailer));
+    const Block restarts(data.data(), data.size(), false,
+                         BlockFormat::kRestarts);
+
+    for (const Block* block : {&plain, &restarts}) {
+        Block::Iter it(block);
+        it.Seek("b");
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.entry().key, "b");
+        EXPECT_EQ(it.entry().type, ValueType::kDeletion);
+        it.Next();
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.entry().value, "3");
+        it.Next();
+        EXPECT_FALSE(it.Valid());
+    }
+}
+
+// 测试 9：共享长前缀的 key 只存一次前缀，读回来的 key 和原来完全一样
+TEST(BlockPrefixTest, SharedPrefixRoundTrip) {
+    BlockBuilder builder(4);
+    std::vector<std::string> keys;
+    size_t raw_bytes = 0;
+    for (int i = 0; i < 40; ++i) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "tenant:42:object:%06d", i * 7);
+        keys.emplace_back(buf);
+        // value 超过 127 字节，长度要用两个字节的 varint
+        const std::string value(200 + i, static_cast<char>('a' + i % 26));
+        builder.Add(keys.back(), value, ValueType::kValue);
+        raw_bytes += 4 + keys.back().size() + 1 + 4 + value.size();
+    }
+    const std::string data = builder.Finish();
+    // 重启点之间的记录省下十几字节的前缀和 6 字节的长度
+    EXPECT_LT(data.size() + 40 * 15, raw_bytes);
+
+    const Block block(data.data(), data.size(), false,
+                      BlockFormat::kPrefixCompressed);
+    Block::Iter it(&block);
+    size_t i = 0;
+    for (it.SeekToFirst(); it.Valid(); it.Next(), ++i) {
+        ASSERT_LT(i, keys.size());
+        EXPECT_EQ(it.entry().key, keys[i]);
+        EXPECT_EQ(it.entry().value.size(), 200 + i);
+    }
+    EXPECT_EQ(i, keys.size());
+
+    // 落在重启点之间的 key 要靠前一条拼出来
+    for (size_t j = 0; j < keys.size(); ++j) {
+        it.Seek(keys[j]);
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.entry().key, keys[j]);
+    }
+    it.Seek("tenant:42:object:000008");
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.entry().key, "tenant:42:object:000014");
+}
@@ -0,0 +1,52 @@
+#include "Coding.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+TEST(CodingTest, Varint32RoundTrip) {
+  std::vector<uint32_t> values = {0, 1, 127, 128, 255, 300, 16383, 16384};
+  for (uint32_t shift = 0; shift < 32; ++shift) {
+    values.push_back(1u << shift);
+    values.push_back((1u << shift) - 1);
+  }
+  values.push_back(UINT32_MAX);
+
+  std::string buf;
+  for (const uint32_t v : values) {
+    const size_t before = buf.size();
+    PutVarint32(&buf, v);
+    EXPECT_EQ(buf.size() - before, VarintLength(v)) << v;
+  }
+
+  const char* p = buf.data();
+  const char* limit = buf.data() + buf.size();
+  for (const uint32_t v : values) {
+    uint32_t decoded = 0;
+    p = GetVarint32Ptr(p, limit, &decoded);
+    ASSERT_NE(p, nullptr);
+    EXPECT_EQ(decoded, v);
+  }
+  EXPECT_EQ(p, limit);
+}
+
+TEST(CodingTest, LengthBoundaries) {
+  EXPECT_EQ(VarintLength(127), 1u);
+  EXPECT_EQ(VarintLength(128), 2u);
+  EXPECT_EQ(VarintLength(UINT32_MAX), kMaxVarint32Length);
+}
+
+TEST(CodingTest, TruncatedInputFails) {
+  std::string buf;
+  PutVarint32(&buf, UINT32_MAX);
+  uint32_t value = 0;
+  for (size_t len = 0; len < buf.size(); ++len) {
+    EXPECT_EQ(GetVarint32Ptr(buf.data(), buf.data() + len, &value), nullptr);
+  }
+  // 6 个字节都带续位标志的不是合法的 varint32
+  const std::string overlong(6, static_cast<char>(0x80));
+  EXPECT_EQ(GetVarint32Ptr(overlong.data(),
+                           overlong.data() + overlong.size(), &value),
+            nullptr);
+}
@@ -83,3 +83,33 @@ TEST_F(CommandExecutorTest, ReturnsStandardRespErrorsForBadRequests) {
   executor.Execute({}, &response);
   EXPECT_EQ(DrainBuffer(response), "-ERR empty command\r\n");
 }
+
+TEST_F(CommandExecutorTest, MSetAndMDelApplyAllKeys) {
+  DBImpl db(test_db_path);
+  CommandExecutor executor(&db);
+  NetworkBuffer response;
+
+  executor.Execute({"MSET", "a", "1", "b", "2", "c", "3"}, &response);
+  EXPECT_EQ(DrainBuffer(response), "+OK\r\n");
+
+  executor.Execute({"RSCAN", "a"}, &response);
+  EXPECT_EQ(DrainBuffer(response),
+            "*6\r\n$1\r\na\r\n$1\r\n1\r\n$1\r\nb\r\n$1\r\n2\r\n"
+            "$1\r\nc\r\n$1\r\n3\r\n");
+
+  executor.Execute({"mdel", "a", "c", "missing"}, &response);
+  EXPECT_EQ(DrainBuffer(response), "+OK\r\n");
+
+  executor.Execute({"RSCAN", "a"}, &response);
+  EXPECT_EQ(DrainBuffer(response), "*2\r\n$1\r\nb\r\n$1\r\n2\r\n");
+
+  // 参数不成对、没有 key 都按参数个数错误处理，且不写入任何数据
+  executor.Execute({"MSET", "a", "1", "b"}, &response);
+  EXPECT_EQ(DrainBuffer(response),
+            "-ERR wrong number of arguments for 'MSET' command\r\n");
+  executor.Execute({"MDEL"}, &response);
+  EXPECT_EQ(DrainBuffer(response),
+            "-ERR wrong number of arguments for 'MDEL' command\r\n");
+  executor.Execute({"GET", "a"}, &response);
+  EXPECT_EQ(DrainBuffer(response), "$-1\r\n");
+}
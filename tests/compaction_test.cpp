@@ -90,9 +90,8 @@ TEST_F(CompactionTest, L0ToL1CompactionKeepsNewestValue) {
   for (int i = 0; i < 9999; ++i) {
     PutValue(db, "k1_" + std::to_string(i), "v");
   }
-  PutValue(db, "trigger_1",
-           "x");  // 触发第一次 MinorCompaction，生成一个 L0 SST
-  db.Sync();
+  PutValue(db, "trigger_1", "x");
+  db.FlushMemTable();  // 触发第一次 MinorCompaction，生成一个 L0 SST
 
   // 第二批数据：L0 SST 2
   PutValue(db, "dup", "new");
@@ -102,7 +101,7 @@ TEST_F(CompactionTest, L0ToL1CompactionKeepsNewestValue) {
   // 触发第二次 MinorCompaction，由于 L0 数量达到阈值 (>=2)，会随后自动触发
   // L0->L1
   PutValue(db, "trigger_2", "y");
-  db.Sync();
+  db.FlushMemTable();
 
   // 验证层级状态
   EXPECT_EQ(db.LevelSize(0), 0u);
@@ -123,10 +122,11 @@ TEST_F(CompactionTest, RecoverSSTablesWithLevelsOnStartup) {
     for (int i = 0; i < 10000; ++i)
       PutValue(db, "r1_" + std::to_string(i), "v");
     PutValue(db, "t1", "x");
+    db.FlushMemTable();
     for (int i = 0; i < 10000; ++i)
       PutValue(db, "r2_" + std::to_string(i), "v");
     PutValue(db, "t2", "y");
-    db.Sync();
+    db.FlushMemTable();
 
     ASSERT_EQ(db.LevelSize(1), 1u);
   }
@@ -157,7 +157,7 @@ TEST_F(CompactionTest, NextFileNumberIsMonotonicAfterRestart) {
     for (int i = 0; i < 12000; ++i) {
       PutValue(db, "first_" + std::to_string(i), "v");
     }
-    db.Sync();
+    db.FlushMemTable();
     max_id_before = GetMaxFileNumberOnDisk(test_db_path);
   }
 
@@ -179,11 +179,11 @@ TEST_F(CompactionTest, NextFileNumberIsMonotonicAfterRestart) {
 TEST_F(CompactionTest, CompactDropsBottomMostTombstonesWithoutCreatingNewSST) {
   DBImpl db(test_db_path);
 
-  // 1. 构造一个仅包含 tombstone 的 L0 SST (10001条数据触发 Minor)
+  // 1. 构造一个仅包含 tombstone 的 L0 SST
   for (int i = 0; i <= 10000; ++i) {
     PutDeletion(db, "ghost_" + std::to_string(i));
   }
-  db.Sync();
+  db.FlushMemTable();
 
   ASSERT_EQ(db.LevelSize(0), 1u);
   ASSERT_EQ(db.LevelSize(1), 0u);
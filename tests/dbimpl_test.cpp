@@ -3,10 +3,13 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "WalHandler.h"
@@ -29,7 +32,7 @@ void ForceMinorCompaction(DBImpl& db, const std::string& prefix) {
     PutValue(db, prefix + "_fill_" + std::to_string(i), "v");
   }
   PutValue(db, prefix + "_trigger", "x");
-  db.Sync();
+  db.FlushMemTable();
 }
 bool GetValue(const DBImpl& db, const std::string& key, std::string& value) {
   ValueRecord record{ValueType::kValue, ""};
@@ -151,11 +154,11 @@ TEST_F(DBImplTest, MixedLayerSearch) {
   for (int i = 0; i < 5000; i++) {
     PutValue(db, "old_" + std::to_string(i), "v" + std::to_string(i));
   }
-  // 写入第 10001 条触发落盘
   for (int i = 5000; i < 10001; i++) {
     PutValue(db, "old_" + std::to_string(i), "v" + std::to_string(i));
   }
-  db.Sync();
+  // 触发落盘
+  db.FlushMemTable();
 
   // 第二步：再写入一些数据留在 MemTable 中
   PutValue(db, "active_key", "active_val");
@@ -180,7 +183,7 @@ TEST_F(DBImplTest, LargeValueCompaction) {
   for (int i = 0; i < 10000; i++) {
     PutValue(db, "fill_" + std::to_string(i), "data");
   }
-  db.Sync();
+  db.FlushMemTable();
 
   std::string result;
   EXPECT_TRUE(GetValue(db, "large_key", result));
@@ -196,15 +199,15 @@ TEST_F(DBImplTest, NewestSSTableWins) {
   for (int i = 0; i < 9999; ++i) {
     PutValue(db, "k1_" + std::to_string(i), "v");
   }
-  PutValue(db, "trigger_1", "x");  // 触发第一次 MinorCompaction
-  db.Sync();
+  PutValue(db, "trigger_1", "x");
+  db.FlushMemTable();  // 触发第一次 MinorCompaction
 
   PutValue(db, "dup", "new");
   for (int i = 0; i < 9999; ++i) {
     PutValue(db, "k2_" + std::to_string(i), "v");
   }
-  PutValue(db, "trigger_2", "y");  // 触发第二次 MinorCompaction
-  db.Sync();
+  PutValue(db, "trigger_2", "y");
+  db.FlushMemTable();  // 触发第二次 MinorCompaction
 
   std::string val;
   EXPECT_TRUE(GetValue(db, "dup", val));
@@ -305,8 +308,9 @@ TEST_F(DBImplTest, MultiWalRecoveryReplaysAllLogsInFileNumberOrder) {
 // 12. Phase 2: 日志主写达到阈值后应触发 checkpoint，并将 MANIFEST.log 截断
 // Test Intent: 验证“日志主写 + 周期快照”链路在阈值点会落快照并清空增量日志。
 TEST_F(DBImplTest, ManifestCheckpointTruncatesLogAtThreshold) {
-  constexpr int kSeedWalFiles =
-      98;  // 构造阶段会额外产生 2 条 edit，总计 100 次
+  // 每个 WAL 回放时登记一次、回放完删除一次，构造阶段另外产生 2 条 edit，
+  // 总计 49 * 2 + 2 = 100 次
+  constexpr int kSeedWalFiles = 49;
   for (int i = 1; i <= kSeedWalFiles; ++i) {
     const std::string wal_path =
         test_db_path + "/" + std::to_string(i) + ".wal";
@@ -328,3 +332,779 @@ TEST_F(DBImplTest, ManifestCheckpointTruncatesLogAtThreshold) {
   ASSERT_TRUE(fs::exists(manifest_log_path));
   EXPECT_EQ(fs::file_size(manifest_log_path), 0u);
 }
+
+// 13. 落盘时机由 write_buffer_size 的字节数决定，而不是条数
+// Test Intent: 大 value 很快写满 MemTable 并落盘，小 value 在阈值内不会触发落盘。
+TEST_F(DBImplTest, FlushIsTriggeredByWriteBufferBytes) {
+  DBOptions options;
+  options.write_buffer_size = 64 * 1024;
+  {
+    DBImpl db(test_db_path, options);
+    for (int i = 0; i < 200; ++i) {
+      PutValue(db, "small_" + std::to_string(i), "0123456789abcdef");
+    }
+    db.Sync();
+    EXPECT_EQ(db.GetStatus().minor_compact_count, 0u);
+  }
+
+  fs::remove_all(test_db_path);
+  fs::create_directories(test_db_path);
+
+  DBImpl db(test_db_path, options);
+  const std::string big_value(8 * 1024, 'B');
+  for (int i = 0; i < 100; ++i) {
+    PutValue(db, "big_" + std::to_string(i), big_value);
+  }
+  db.Sync();
+
+  const DBStatus s = db.GetStatus();
+  // 100 * 8KB 约 800KB，按 64KB 切换至少要落盘十次
+  EXPECT_GE(s.minor_compact_count, 10u);
+  EXPECT_LT(s.mem_bytes, options.write_buffer_size + big_value.size() * 2);
+
+  std::string val;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(GetValue(db, "big_" + std::to_string(i), val));
+    EXPECT_EQ(val.size(), big_value.size());
+  }
+}
+
+// 14. 多张 imm 排队落盘：同一个 key 分散在多张 MemTable 里时，读到的始终是最新版本
+// Test Intent: 验证 imm 队列“读从新到旧、落盘从旧到新”，突发写入不会丢数据或读到旧值。
+TEST_F(DBImplTest, QueuedImmutableMemTablesKeepNewestVersion) {
+  DBOptions options;
+  options.write_buffer_size = 16 * 1024;
+  options.max_immutable_memtables = 3;
+  DBImpl db(test_db_path, options);
+
+  const std::string filler(1024, 'f');
+  for (int round = 0; round < 30; ++round) {
+    PutValue(db, "hot", "v" + std::to_string(round));
+    for (int i = 0; i < 20; ++i) {
+      PutValue(db, "r" + std::to_string(round) + "_" + std::to_string(i),
+               filler);
+    }
+    std::string val;
+    ASSERT_TRUE(GetValue(db, "hot", val));
+    EXPECT_EQ(val, "v" + std::to_string(round));
+  }
+
+  const DBStatus before_sync = db.GetStatus();
+  EXPECT_LE(before_sync.imm_tables, options.max_immutable_memtables);
+
+  db.Sync();
+  const DBStatus s = db.GetStatus();
+  EXPECT_EQ(s.imm_tables, 0u);
+  EXPECT_EQ(s.imm_count, 0u);
+  EXPECT_GT(s.minor_compact_count, 1u);
+
+  std::string val;
+  EXPECT_TRUE(GetValue(db, "hot", val));
+  EXPECT_EQ(val, "v29");
+  EXPECT_TRUE(GetValue(db, "r0_0", val));
+  EXPECT_TRUE(GetValue(db, "r29_19", val));
+}
+
+// 15. 打开 MemTable 哈希索引后，读写、落盘、迭代行为保持不变
+TEST_F(DBImplTest, HashIndexedMemTableKeepsSemantics) {
+  DBOptions options;
+  options.write_buffer_size = 64 * 1024;
+  options.memtable_hash_index = true;
+  DBImpl db(test_db_path, options);
+
+  for (int i = 0; i < 3000; ++i) {
+    PutValue(db, "key_" + std::to_string(i), "v" + std::to_string(i));
+  }
+  PutDeletion(db, "key_42");
+  db.Sync();
+
+  std::string val;
+  EXPECT_TRUE(GetValue(db, "key_0", val));
+  EXPECT_EQ(val, "v0");
+  EXPECT_TRUE(GetValue(db, "key_2999", val));
+  EXPECT_EQ(val, "v2999");
+  EXPECT_FALSE(GetValue(db, "key_42", val));
+  EXPECT_FALSE(GetValue(db, "absent", val));
+  EXPECT_GT(db.GetStatus().minor_compact_count, 0u);
+}
+
+// 16. vector 实现的 MemTable：写入、落盘、重启恢复的结果和跳表实现一致
+TEST_F(DBImplTest, VectorMemTableRepFlushesSortedSST) {
+  DBOptions options;
+  options.write_buffer_size = 64 * 1024;
+  options.memtable_rep = MemTableRepType::kVector;
+  {
+    DBImpl db(test_db_path, options);
+    // 倒序写入 + 覆盖 + 删除
+    for (int i = 2999; i >= 0; --i) {
+      PutValue(db, "key_" + std::to_string(i), "v" + std::to_string(i));
+    }
+    PutValue(db, "key_10", "overwritten");
+    PutDeletion(db, "key_20");
+    db.Sync();
+    EXPECT_GT(db.GetStatus().minor_compact_count, 0u);
+
+    std::string val;
+    EXPECT_TRUE(GetValue(db, "key_10", val));
+    EXPECT_EQ(val, "overwritten");
+    EXPECT_FALSE(GetValue(db, "key_20", val));
+  }
+
+  DBImpl db_recovered(test_db_path, options);
+  std::string val;
+  EXPECT_TRUE(GetValue(db_recovered, "key_0", val));
+  EXPECT_EQ(val, "v0");
+  EXPECT_TRUE(GetValue(db_recovered, "key_10", val));
+  EXPECT_EQ(val, "overwritten");
+  EXPECT_FALSE(GetValue(db_recovered, "key_20", val));
+
+  auto it = db_recovered.NewIterator();
+  it->Seek("key_");
+  size_t rows = 0;
+  std::string prev;
+  while (it->Valid()) {
+    EXPECT_LT(prev, it->key());
+    prev = it->key();
+    ++rows;
+    it->Next();
+  }
+  EXPECT_EQ(rows, 2999u);
+}
+
+// 17. 三种 WAL 同步模式：写入返回后记录都已经完整地落在 WAL 文件里
+TEST_F(DBImplTest, WalSyncModesPersistEveryRecord) {
+  for (const auto mode : {WalSyncMode::kNone, WalSyncMode::kEveryWrite,
+                          WalSyncMode::kPeriodic}) {
+    fs::remove_all(test_db_path);
+    DBOptions options;
+    options.wal_sync_mode = mode;
+    options.wal_sync_interval_ms = 5;
+    options.wal_bytes_per_sync = 1024;
+    DBImpl db(test_db_path, options);
+    for (int i = 0; i < 100; ++i) {
+      WriteOptions write_options;
+      write_options.sync = i % 10 == 0;
+      db.Put("key_" + std::to_string(i),
+             ValueRecord{ValueType::kValue, "v" + std::to_string(i)},
+             write_options);
+    }
+
+    // DB 还开着（不经过析构落盘），直接从 WAL 文件里读回所有记录
+    size_t records = 0;
+    for (const auto& entry : fs::directory_iterator(test_db_path)) {
+      if (entry.path().extension() != ".wal") {
+        continue;
+      }
+      WalHandler wal(entry.path().string());
+      wal.LoadLog([&records](ValueType, const std::string&,
+                             const std::string&) { ++records; });
+    }
+    EXPECT_EQ(records, 100u);
+  }
+}
+
+// 18. 多个 WAL 并行解析、按文件号顺序应用，超过 write_buffer_size 就落一张 L0，
+// 回放完的 WAL 被删除，再次打开不会重复回放
+TEST_F(DBImplTest, WalRecoveryFlushesToL0WithinWriteBuffer) {
+  const std::string value(1024, 'r');
+  for (int w = 1; w <= 6; ++w) {
+    WalHandler wal(test_db_path + "/" + std::to_string(w) + ".wal");
+    for (int i = 0; i < 500; ++i) {
+      // 相邻 WAL 的 key 有重叠，后面的文件覆盖前面的
+      const int k = w * 250 + i;
+      wal.AddLog("key_" + std::to_string(k),
+                 value + std::to_string(w), ValueType::kValue);
+    }
+  }
+  {
+    WalHandler wal(test_db_path + "/7.wal");
+    wal.AddLog("key_1800", "", ValueType::kDeletion);
+  }
+
+  DBOptions options;
+  options.write_buffer_size = 256 * 1024;
+  size_t l0_after_recovery = 0;
+  {
+    DBImpl db(test_db_path, options);
+    l0_after_recovery = db.LevelSize(0) + db.LevelSize(1);
+    // 3000 条 1KB 的记录，一张 MemTable 放不下
+    EXPECT_GT(l0_after_recovery, 2u);
+    EXPECT_EQ(CountNumericFilesWithExt(test_db_path, ".wal"), 1u);
+
+    std::string val;
+    EXPECT_TRUE(GetValue(db, "key_250", val));
+    EXPECT_EQ(val, value + "1");
+    EXPECT_TRUE(GetValue(db, "key_600", val));
+    EXPECT_EQ(val, value + "2");
+    EXPECT_TRUE(GetValue(db, "key_1749", val));
+    EXPECT_EQ(val, value + "6");
+    EXPECT_FALSE(GetValue(db, "key_1800", val));
+  }
+
+  DBImpl db(test_db_path, options);
+  EXPECT_EQ(db.LevelSize(0) + db.LevelSize(1), l0_after_recovery);
+  std::string val;
+  EXPECT_TRUE(GetValue(db, "key_600", val));
+  EXPECT_EQ(val, value + "2");
+}
+
+// 19. 复用旧 WAL：落盘后的 WAL 改名留着，切换 MemTable 时拿来覆盖写，
+// 重启后既不丢数据，也不会回放复用文件里的旧内容
+TEST_F(DBImplTest, RecycledWalsAreReusedAndNeverReplayed) {
+  DBOptions options;
+  options.write_buffer_size = 64 * 1024;
+  options.recycle_wal_files = 2;
+  {
+    DBImpl db(test_db_path, options);
+    for (int round = 0; round < 3; ++round) {
+      for (int i = 0; i < 2000; ++i) {
+        PutValue(db, "key_" + std::to_string(i),
+                 "r" + std::to_string(round) + std::string(100, 'x'));
+      }
+    }
+    PutDeletion(db, "key_7");
+    db.Sync();
+    EXPECT_GT(db.GetStatus().minor_compact_count, 2u);
+    const size_t recycled = CountNumericFilesWithExt(test_db_path, ".recycle");
+    EXPECT_GT(recycled, 0u);
+    EXPECT_LE(recycled, 2u);
+  }
+
+  DBImpl db(test_db_path, options);
+  std::string val;
+  for (int i = 0; i < 2000; i += 97) {
+    if (i == 7) continue;
+    EXPECT_TRUE(GetValue(db, "key_" + std::to_string(i), val));
+    EXPECT_EQ(val, "r2" + std::string(100, 'x'));
+  }
+  EXPECT_FALSE(GetValue(db, "key_7", val));
+  EXPECT_LE(CountNumericFilesWithExt(test_db_path, ".recycle"), 2u);
+}
+
+// 20. WriteBatch：并发扫描要么看到整批、要么一条也看不到；重启后整批都在
+TEST_F(DBImplTest, WriteBatchIsAtomicForReadersAndRecovery) {
+  constexpr int kKeys = 10;
+  constexpr int kRounds = 300;
+  {
+    DBImpl db(test_db_path);
+    std::atomic<bool> done{false};
+    std::thread writer([&db, &done]() {
+      for (int round = 1; round <= kRounds; ++round) {
+        WriteBatch batch;
+        for (int i = 0; i < kKeys; ++i) {
+          batch.Put("batch_" + std::to_string(i), std::to_string(round));
+        }
+        db.Write(batch);
+      }
+      done = true;
+    });
+    while (!done) {
+      std::vector<std::string> values;
+      for (auto it = db.NewIterator("batch_"); it->Valid(); it->Next()) {
+        values.push_back(it->value());
+      }
+      if (values.empty()) continue;
+      ASSERT_EQ(values.size(), static_cast<size_t>(kKeys));
+      for (const auto& v : values) {
+        ASSERT_EQ(v, values[0]);
+      }
+    }
+    writer.join();
+
+    WriteBatch batch;
+    batch.Delete("batch_0");
+    batch.Put("batch_1", "last");
+    db.Write(batch);
+  }
+
+  DBImpl db(test_db_path);
+  std::string val;
+  EXPECT_FALSE(GetValue(db, "batch_0", val));
+  EXPECT_TRUE(GetValue(db, "batch_1", val));
+  EXPECT_EQ(val, "last");
+  EXPECT_TRUE(GetValue(db, "batch_9", val));
+  EXPECT_EQ(val, std::to_string(kRounds));
+}
+
+// 21. 快照：Get 和迭代器都读到拿快照那一刻的值，落盘和 L0->L1 之后依然如此
+TEST_F(DBImplTest, SnapshotReadsSurviveFlushAndCompaction) {
+  DBImpl db(test_db_path);
+  PutValue(db, "snap_key", "v1");
+  PutValue(db, "snap_gone", "alive");
+  const Snapshot* snapshot = db.GetSnapshot();
+  PutValue(db, "snap_key", "v2");
+  PutDeletion(db, "snap_gone");
+  PutValue(db, "snap_new", "new");
+
+  ReadOptions read_options;
+  read_options.snapshot = snapshot;
+  auto check = [&]() {
+    ValueRecord record{ValueType::kValue, ""};
+    ASSERT_TRUE(db.Get("snap_key", record, read_options));
+    EXPECT_EQ(record.value, "v1");
+    ASSERT_TRUE(db.Get("snap_gone", record, read_options));
+    EXPECT_EQ(record.value, "alive");
+    EXPECT_FALSE(db.Get("snap_new", record, read_options));
+
+    std::vector<std::string> rows;
+    for (auto it = db.NewIterator(read_options, "snap_"); it->Valid();
+         it->Next()) {
+      rows.push_back(it->key() + "=" + it->value());
+    }
+    EXPECT_EQ(rows,
+              (std::vector<std::string>{"snap_gone=alive", "snap_key=v1"}));
+
+    std::string val;
+    EXPECT_TRUE(GetValue(db, "snap_key", val));
+    EXPECT_EQ(val, "v2");
+    EXPECT_FALSE(GetValue(db, "snap_gone", val));
+    EXPECT_TRUE(GetValue(db, "snap_new", val));
+  };
+
+  check();
+  db.FlushMemTable();
+  check();
+  // 第二个 L0 文件触发 L0->L1，快照还需要的旧版本和 tombstone 都要留下
+  PutValue(db, "other", "x");
+  db.FlushMemTable();
+  EXPECT_EQ(db.LevelSize(0), 0u);
+  EXPECT_EQ(db.LevelSize(1), 1u);
+  check();
+
+  db.ReleaseSnapshot(snapshot);
+  std::string val;
+  EXPECT_TRUE(GetValue(db, "snap_key", val));
+  EXPECT_EQ(val, "v2");
+}
+
+// 22. 重启后序号接着 SST 和 WAL 里最大的往下编，新写入盖过旧数据
+TEST_F(DBImplTest, SequenceContinuesAfterRecovery) {
+  {
+    DBImpl db(test_db_path);
+    PutValue(db, "seq_key", "flushed");
+    db.FlushMemTable();
+    PutValue(db, "seq_key", "in_wal");
+  }
+  {
+    DBImpl db(test_db_path);
+    const Snapshot* snapshot = db.GetSnapshot();
+    EXPECT_GE(snapshot->sequence(), 2u);
+    PutValue(db, "seq_key", "after_restart");
+    ReadOptions read_options;
+    read_options.snapshot = snapshot;
+    ValueRecord record{ValueType::kValue, ""};
+    ASSERT_TRUE(db.Get("seq_key", record, read_options));
+    EXPECT_EQ(record.value, "in_wal");
+    db.ReleaseSnapshot(snapshot);
+  }
+  DBImpl db(test_db_path);
+  std::string val;
+  EXPECT_TRUE(GetValue(db, "seq_key", val));
+  EXPECT_EQ(val, "after_restart");
+}
+
+// 23. 写入限速：L0 超过软上限时按令牌桶限速，超过硬上限时停写，
+// 后台合并掉 L0 之后恢复正常，等待时间记在 DBStatus 里
+TEST_F(DBImplTest, WriteStallDelaysThenStopsUntilL0Compacted) {
+  DBOptions options;
+  options.level0_compaction_trigger = 100;
+  options.level0_slowdown_writes_trigger = 2;
+  options.level0_stop_writes_trigger = 0;
+  options.delayed_write_rate = 256 * 1024;
+  {
+    DBImpl db(test_db_path, options);
+    PutValue(db, "stall_a", "v");
+    db.FlushMemTable();
+    EXPECT_EQ(db.GetStatus().write_stall, WriteStallCondition::kNormal);
+    PutValue(db, "stall_b", "v");
+    db.FlushMemTable();
+    ASSERT_EQ(db.LevelSize(0), 2u);
+
+    DBStatus s = db.GetStatus();
+    EXPECT_EQ(s.write_stall, WriteStallCondition::kDelayed);
+    EXPECT_EQ(s.delayed_write_rate, options.delayed_write_rate);
+
+    // 64KB 按 256KB/s 限速，至少要等上百毫秒
+    const std::string value(4096, 'd');
+    for (int i = 0; i < 16; ++i) {
+      PutValue(db, "delayed_" + std::to_string(i), value);
+    }
+    s = db.GetStatus();
+    EXPECT_GE(s.write_delay_micros, 100000u);
+    EXPECT_EQ(s.write_stop_micros, 0u);
+    db.FlushMemTable();
+    ASSERT_EQ(db.LevelSize(0), 3u);
+  }
+
+  // 重新打开时 L0 已经到了停写线：第一次写入要等后台把 L0 合并掉
+  options.level0_stop_writes_trigger = 3;
+  DBImpl db(test_db_path, options);
+  EXPECT_EQ(db.GetStatus().write_stall, WriteStallCondition::kStopped);
+  PutValue(db, "after_stop", "v");
+
+  const DBStatus s = db.GetStatus();
+  EXPECT_EQ(s.write_stall, WriteStallCondition::kNormal);
+  EXPECT_EQ(s.delayed_write_rate, 0u);
+  EXPECT_GT(s.write_stop_micros, 0u);
+  EXPECT_EQ(db.LevelSize(0), 0u);
+  EXPECT_EQ(db.LevelSize(1), 1u);
+
+  std::string val;
+  EXPECT_TRUE(GetValue(db, "after_stop", val));
+  EXPECT_TRUE(GetValue(db, "stall_a", val));
+  EXPECT_TRUE(GetValue(db, "delayed_15", val));
+  EXPECT_EQ(val.size(), 4096u);
+}
+
+// 24. 块缓存：同一个 SST 块的重复点查命中缓存，DBStatus 里能看到命中率；
+// 关掉缓存时读照样正确
+TEST_F(DBImplTest, BlockCacheServesRepeatedReads) {
+  DBOptions options;
+  options.block_cache_capacity = 1024 * 1024;
+  {
+    DBImpl db(test_db_path, options);
+    for (int i = 0; i < 100; ++i) {
+      PutValue(db, "cached_" + std::to_string(i), "v" + std::to_string(i));
+    }
+    db.FlushMemTable();
+
+    std::string val;
+    ASSERT_TRUE(GetValue(db, "cached_1", val));
+    const DBStatus first = db.GetStatus();
+    EXPECT_GE(first.block_cache_misses, 1u);
+    EXPECT_GT(first.block_cache_usage, 0u);
+
+    for (int round = 0; round < 10; ++round) {
+      ASSERT_TRUE(GetValue(db, "cached_1", val));
+      EXPECT_EQ(val, "v1");
+    }
+    const DBStatus s = db.GetStatus();
+    EXPECT_GE(s.block_cache_hits, first.block_cache_hits + 10);
+    EXPECT_EQ(s.block_cache_misses, first.block_cache_misses);
+    EXPECT_LE(s.block_cache_usage, options.block_cache_capacity);
+  }
+
+  options.block_cache_capacity = 0;
+  DBImpl db(test_db_path, options);
+  std::string val;
+  ASSERT_TRUE(GetValue(db, "cached_99", val));
+  EXPECT_EQ(val, "v99");
+  const DBStatus s = db.GetStatus();
+  EXPECT_EQ(s.block_cache_hits + s.block_cache_misses, 0u);
+}
+
+// 25. 零拷贝 Get：pin 住的 value 在 MemTable 落盘、SST 被 Compaction 删掉
+// 之后仍然有效；有没有块缓存都一样
+TEST_F(DBImplTest, PinnedGetOutlivesFlushAndCompaction) {
+  for (const size_t cache_capacity : {size_t{0}, size_t{1024 * 1024}}) {
+    fs::remove_all(test_db_path);
+    fs::create_directories(test_db_path);
+    DBOptions options;
+    options.block_cache_capacity = cache_capacity;
+    DBImpl db(test_db_path, options);
+
+    const std::string big(100 * 1024, 'p');
+    PutValue(db, "pinned", big);
+    PinnedValue from_mem;
+    ASSERT_TRUE(db.Get("pinned", &from_mem));
+    db.FlushMemTable();
+    EXPECT_EQ(from_mem.value(), big);
+
+    PinnedValue from_sst;
+    ASSERT_TRUE(db.Get("pinned", &from_sst));
+    EXPECT_EQ(from_sst.value(), big);
+
+    // 新版本落盘后 L0 到了合并线，旧 SST 被合并掉、文件被删除
+    PutValue(db, "pinned", "new");
+    db.FlushMemTable();
+    db.Sync();
+    db.CompactL0ToL1();
+    ASSERT_EQ(db.LevelSize(0), 0u);
+    EXPECT_EQ(from_sst.value(), big);
+    EXPECT_EQ(from_mem.value(), big);
+
+    PinnedValue latest;
+    ASSERT_TRUE(db.Get("pinned", &latest));
+    EXPECT_EQ(latest.value(), "new");
+
+    PutDeletion(db, "pinned");
+    EXPECT_FALSE(db.Get("pinned", &latest));
+    EXPECT_EQ(latest.size(), 0u);
+  }
+}
+
+// 26. TableCache：重新打开时只登记 SST 不打开，读到时才打开；
+// 打开的文件数不超过 max_open_files，所有 key 照样读得到
+TEST_F(DBImplTest, TableCacheOpensSstsLazily) {
+  DBOptions options;
+  options.level0_compaction_trigger = 100;
+  options.max_open_files = 2;
+  {
+    DBImpl db(test_db_path, options);
+    for (int file = 0; file < 5; ++file) {
+      PutValue(db, "lazy_" + std::to_string(file), "v" + std::to_string(file));
+      db.FlushMemTable();
+    }
+    ASSERT_EQ(db.LevelSize(0), 5u);
+    EXPECT_LE(db.GetStatus().open_tables, 2u);
+  }
+
+  DBImpl db(test_db_path, options);
+  EXPECT_EQ(db.LevelSize(0), 5u);
+  EXPECT_EQ(db.GetStatus().open_tables, 0u);
+
+  for (int round = 0; round < 2; ++round) {
+    for (int file = 0; file < 5; ++file) {
+      std::string val;
+      ASSERT_TRUE(GetValue(db, "lazy_" + std::to_string(file), val));
+      EXPECT_EQ(val, "v" + std::to_string(file));
+      EXPECT_LE(db.GetStatus().open_tables, 2u);
+    }
+  }
+  EXPECT_GT(db.GetStatus().open_tables, 0u);
+
+  // 迭代器要同时读所有文件，它自己持有被淘汰的 reader
+  auto it = db.NewIterator();
+  int count = 0;
+  for (; it->Valid(); it->Next()) {
+    ++count;
+  }
+  EXPECT_EQ(count, 5);
+}
+
+// 27. WAL 同步策略真的传到了 WalHandler：kEveryWrite 每次写入 fdatasync 一次，
+// kPeriodic 在攒够 wal_bytes_per_sync 字节时由写入路径同步
+TEST_F(DBImplTest, WalSyncPolicyReachesWalHandler) {
+  {
+    DBOptions options;
+    options.wal_sync_mode = WalSyncMode::kEveryWrite;
+    DBImpl db(test_db_path, options);
+    EXPECT_EQ(db.GetStatus().wal_syncs, 0u);
+    for (int i = 1; i <= 3; ++i) {
+      PutValue(db, "every_" + std::to_string(i), "v");
+      const DBStatus status = db.GetStatus();
+      EXPECT_EQ(status.wal_syncs, static_cast<uint64_t>(i));
+      EXPECT_EQ(status.wal_unsynced_bytes, 0u);
+    }
+  }
+
+  fs::remove_all(test_db_path);
+  DBOptions options;
+  options.wal_sync_mode = WalSyncMode::kPeriodic;
+  // 后台线程在测试期间不会醒来，同步只能来自字节阈值
+  options.wal_sync_interval_ms = 3600 * 1000;
+  options.wal_bytes_per_sync = 4096;
+  DBImpl db(test_db_path, options);
+  const std::string value(100, 'p');
+  int writes = 0;
+  while (db.GetStatus().wal_syncs == 0) {
+    ASSERT_LT(writes, 100) << "bytes_per_sync never triggered a sync";
+    const size_t unsynced = db.GetStatus().wal_unsynced_bytes;
+    EXPECT_LT(unsynced, options.wal_bytes_per_sync);
+    PutValue(db, "periodic_" + std::to_string(writes++), value);
+  }
+  // 每条记录一百多字节，4096 字节大约要三十多次写入才触发一次同步
+  EXPECT_GT(writes, 20);
+  EXPECT_EQ(db.GetStatus().wal_syncs, 1u);
+  EXPECT_EQ(db.GetStatus().wal_unsynced_bytes, 0u);
+}
+
+// 28. 流水线写：多线程并发 Put（部分要求同步）夹着一个 WriteBatch，
+// 写的过程中 MemTable 按字节数和手动 Flush 不停切换，每张旧表的 WAL 线程
+// 都要干净地退出；重启后每个 key 都在
+TEST_F(DBImplTest, PipelinedWritesSurviveRotationAndReopen) {
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 500;
+  DBOptions options;
+  options.pipelined_write = true;
+  options.write_buffer_size = 16 * 1024;
+  {
+    DBImpl db(test_db_path, options);
+    std::atomic<bool> writing{true};
+    std::thread flusher([&db, &writing]() {
+      while (writing) {
+        db.FlushMemTable();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t) {
+      writers.emplace_back([&db, t]() {
+        for (int i = 0; i < kPerThread; ++i) {
+          WriteOptions write_options;
+          write_options.sync = i % 50 == 0;
+          db.Put("pipe_" + std::to_string(t) + "_" + std::to_string(i),
+                 ValueRecord{ValueType::kValue, std::to_string(i)},
+                 write_options);
+        }
+      });
+    }
+    WriteBatch batch;
+    for (int i = 0; i < 10; ++i) {
+      batch.Put("pipe_batch_" + std::to_string(i), "b");
+    }
+    batch.Delete("pipe_0_0");
+    db.Write(batch);
+    for (auto& writer : writers) {
+      writer.join();
+    }
+    writing = false;
+    flusher.join();
+    EXPECT_GT(db.GetStatus().minor_compact_count, 1u);
+    // 切到一张新表之后还能写，读到的是写入返回后就公布了的值
+    PutValue(db, "pipe_after", "x");
+    std::string val;
+    ASSERT_TRUE(GetValue(db, "pipe_after", val));
+  }
+
+  DBImpl db(test_db_path, options);
+  std::string val;
+  for (int t = 0; t < kThreads; ++t) {
+    for (int i = 0; i < kPerThread; ++i) {
+      const std::string key =
+          "pipe_" + std::to_string(t) + "_" + std::to_string(i);
+      if (key == "pipe_0_0") {
+        // 和 WriteBatch 里的 Delete 谁先谁后不确定
+        continue;
+      }
+      ASSERT_TRUE(GetValue(db, key, val)) << key;
+      EXPECT_EQ(val, std::to_string(i));
+    }
+  }
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(GetValue(db, "pipe_batch_" + std::to_string(i), val));
+    EXPECT_EQ(val, "b");
+  }
+  EXPECT_TRUE(GetValue(db, "pipe_after", val));
+}
+
+// 29. Get 填回读到的版本的序号：MemTable、快照和落盘后的 SST 上都一样
+TEST_F(DBImplTest, GetReportsVersionSequence) {
+  DBImpl db(test_db_path);
+  PutValue(db, "seq_key", "v1");
+  ValueRecord first{ValueType::kValue, ""};
+  ASSERT_TRUE(db.Get("seq_key", first));
+  EXPECT_GT(first.sequence, 0u);
+
+  const Snapshot* snapshot = db.GetSnapshot();
+  PutValue(db, "seq_key", "v2");
+  ValueRecord second{ValueType::kValue, ""};
+  ASSERT_TRUE(db.Get("seq_key", second));
+  EXPECT_EQ(second.value, "v2");
+  EXPECT_GT(second.sequence, first.sequence);
+
+  db.FlushMemTable();
+  ValueRecord flushed{ValueType::kValue, ""};
+  ASSERT_TRUE(db.Get("seq_key", flushed));
+  EXPECT_EQ(flushed.sequence, second.sequence);
+
+  ReadOptions read_options;
+  read_options.snapshot = snapshot;
+  ValueRecord old{ValueType::kValue, ""};
+  ASSERT_TRUE(db.Get("seq_key", old, read_options));
+  EXPECT_EQ(old.value, "v1");
+  EXPECT_EQ(old.sequence, first.sequence);
+  db.ReleaseSnapshot(snapshot);
+}
+
+// 30. max_immutable_memtables 为 0 时按 1 处理，写满 MemTable 不会永远等下去
+TEST_F(DBImplTest, ZeroImmutableMemTableLimitIsClampedToOne) {
+  DBOptions options;
+  options.write_buffer_size = 16 * 1024;
+  options.max_immutable_memtables = 0;
+  DBImpl db(test_db_path, options);
+  const std::string value(256, 'z');
+  for (int i = 0; i < 500; ++i) {
+    PutValue(db, "clamp_" + std::to_string(i), value);
+  }
+  EXPECT_GT(db.GetStatus().minor_compact_count, 0u);
+  std::string val;
+  ASSERT_TRUE(GetValue(db, "clamp_0", val));
+  EXPECT_EQ(val, value);
+}
+
+// 31. 较新的 SST 打不开时 Get 报错而不是退回更旧的文件，迭代器同样创建失败
+TEST_F(DBImplTest, UnreadableNewerSstDoesNotExposeOlderValue) {
+  DBOptions options;
+  options.level0_compaction_trigger = 100;
+  {
+    DBImpl db(test_db_path, options);
+    PutValue(db, "broken_key", "old");
+    db.FlushMemTable();
+    PutValue(db, "broken_key", "new");
+    db.FlushMemTable();
+    ASSERT_EQ(db.LevelSize(0), 2u);
+  }
+
+  // 重新打开时只读 Footer，两个文件都还没打开；此时把较新的那个截断
+  DBImpl db(test_db_path, options);
+  uint64_t newest = 0;
+  for (const auto& entry : fs::directory_iterator(test_db_path)) {
+    if (entry.path().extension() == ".sst") {
+      newest = std::max<uint64_t>(newest, std::stoull(entry.path().stem()));
+    }
+  }
+  ASSERT_GT(newest, 0u);
+  fs::resize_file(test_db_path + "/" + std::to_string(newest) + ".sst", 10);
+
+  std::string val;
+  EXPECT_FALSE(GetValue(db, "broken_key", val));
+  EXPECT_NE(val, "old");
+  EXPECT_EQ(db.NewIterator(), nullptr);
+  EXPECT_EQ(db.GetStatus().read_errors, 2u);
+}
+
+// 32. 活跃 WAL 写不进去时 Put / Write 返回 false，DB 拒绝之后的写入，
+// 失败的写入读不到；已经落盘的数据不受影响，重新打开后照常读写
+TEST_F(DBImplTest, WalWriteFailureFailsWrites) {
+  if (!fs::exists("/dev/full")) {
+    GTEST_SKIP() << "/dev/full not available";
+  }
+  std::vector<std::string> links;
+  {
+    DBImpl db(test_db_path);
+    PutValue(db, "before", "v");
+    // 接下来分配的几个文件号都指向 /dev/full，换表后新 WAL 就会写失败
+    uint64_t max_number = 0;
+    for (const auto& entry : fs::directory_iterator(test_db_path)) {
+      const std::string stem = entry.path().stem().string();
+      if (!stem.empty() &&
+          std::all_of(stem.begin(), stem.end(), [](const unsigned char c) {
+            return std::isdigit(c);
+          })) {
+        max_number = std::max<uint64_t>(max_number, std::stoull(stem));
+      }
+    }
+    for (uint64_t n = max_number + 1; n <= max_number + 4; ++n) {
+      links.push_back(test_db_path + "/" + std::to_string(n) + ".wal");
+      fs::create_symlink("/dev/full", links.back());
+    }
+    db.FlushMemTable();
+    ASSERT_EQ(db.LevelSize(0), 1u);
+
+    EXPECT_FALSE(db.Put("after", ValueRecord{ValueType::kValue, "x"}));
+    EXPECT_TRUE(db.GetStatus().wal_failed);
+    WriteBatch batch;
+    batch.Put("batch_after", "x");
+    EXPECT_FALSE(db.Write(batch));
+    // 换不了表，也不会卡住
+    db.FlushMemTable();
+
+    std::string val;
+    EXPECT_FALSE(GetValue(db, "after", val));
+    EXPECT_FALSE(GetValue(db, "batch_after", val));
+    ASSERT_TRUE(GetValue(db, "before", val));
+    EXPECT_EQ(val, "v");
+  }
+
+  for (const auto& link : links) {
+    fs::remove(link);
+  }
+  DBImpl db(test_db_path);
+  std::string val;
+  EXPECT_TRUE(GetValue(db, "before", val));
+  EXPECT_FALSE(GetValue(db, "after", val));
+  EXPECT_FALSE(db.GetStatus().wal_failed);
+  PutValue(db, "reopened", "v");
+  EXPECT_TRUE(GetValue(db, "reopened", val));
+}
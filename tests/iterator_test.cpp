@@ -27,7 +27,7 @@ void ForceMinorCompaction(DBImpl& db, const std::string& prefix) {
     PutValue(db, prefix + "_fill_" + std::to_string(i), "v");
   }
   PutValue(db, prefix + "_trigger", "x");
-  db.Sync();
+  db.FlushMemTable();
 }
 std::vector<std::pair<std::string, std::string>> CollectFrom(
     DBImpl& db, const std::string& start_key) {
@@ -148,3 +148,59 @@ TEST_F(IteratorTest, Iterator_HidesTombstoneAcrossLevels) {
     EXPECT_NE(row.first, "k");
   }
 }
+
+TEST_F(IteratorTest, NewIteratorWithStartKeySkipsEarlierRows) {
+  DBImpl db(test_db_path);
+
+  PutValue(db, "a", "1");
+  PutValue(db, "c", "3");
+  ForceMinorCompaction(db, "b");
+
+  PutValue(db, "d", "4");
+  PutValue(db, "e", "5");
+
+  auto it = db.NewIterator("c");
+  ASSERT_TRUE(it->Valid());
+  EXPECT_EQ(it->key(), "c");
+  EXPECT_EQ(it->value(), "3");
+  it->Next();
+  ASSERT_TRUE(it->Valid());
+  EXPECT_EQ(it->key(), "d");
+
+  // 起点之前的 key 不会被收集，回头 Seek 也只能落在起点上
+  it->Seek("a");
+  ASSERT_TRUE(it->Valid());
+  EXPECT_EQ(it->key(), "c");
+}
+
+TEST_F(IteratorTest, IteratorIsStableAcrossWritesAndCompaction) {
+  DBImpl db(test_db_path);
+
+  PutValue(db, "a", "1");
+  PutValue(db, "b", "2");
+  ForceMinorCompaction(db, "c");
+
+  auto it = db.NewIterator("a");
+  // 创建之后的覆盖、删除、落盘和 L0->L1 都看不到，旧文件也不会被提前关掉
+  PutValue(db, "a", "changed");
+  PutDeletion(db, "b");
+  PutValue(db, "aa", "new");
+  ForceMinorCompaction(db, "d");
+  db.Sync();
+  EXPECT_EQ(db.LevelSize(0), 0u);
+
+  ASSERT_TRUE(it->Valid());
+  EXPECT_EQ(it->key(), "a");
+  EXPECT_EQ(it->value(), "1");
+  it->Next();
+  ASSERT_TRUE(it->Valid());
+  EXPECT_EQ(it->key(), "b");
+  EXPECT_EQ(it->value(), "2");
+
+  const auto latest = CollectFrom(db, "a");
+  ASSERT_GE(latest.size(), 2u);
+  EXPECT_EQ(latest[0].first, "a");
+  EXPECT_EQ(latest[0].second, "changed");
+  EXPECT_EQ(latest[1].first, "aa");
+  EXPECT_EQ(latest[1].second, "new");
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cstdio>
 #include <filesystem>
 #include <string>
 #include <thread>
@@ -135,3 +137,365 @@ TEST_F(MemTableBaseTest, ManualReplayCanRecoverDataAndTombstone) {
     EXPECT_EQ(rec.type, ValueType::kDeletion);
     EXPECT_TRUE(rec.value.empty());
 }
+
+TEST_F(MemTableBaseTest, ConcurrentOverwriteMatchesWalReplay) {
+    const int num_writers = 4;
+    const int num_keys = 64;
+    const int rounds = 200;
+    MemTable mt(persistence_log);
+    std::vector<std::thread> workers;
+
+    // 多个线程反复覆盖同一批 key，最终内存值必须和按 WAL 顺序重放的结果一致
+    for (int i = 0; i < num_writers; ++i) {
+        workers.emplace_back([&mt, i]() {
+            for (int r = 0; r < rounds; ++r) {
+                for (int k = 0; k < num_keys; ++k) {
+                    mt.Put("k_" + std::to_string(k),
+                           MakeValue("w" + std::to_string(i) + "_r" + std::to_string(r)));
+                }
+            }
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    EXPECT_EQ(mt.Count(), num_keys);
+
+    MemTable mt_recovery(basic_log);
+    WalHandler wal(persistence_log);
+    wal.LoadLog([&mt_recovery](ValueType type, const std::string& k, const std::string& v) {
+        mt_recovery.ApplyWithoutWal(k, ValueRecord{type, v});
+    });
+
+    for (int k = 0; k < num_keys; ++k) {
+        const std::string key = "k_" + std::to_string(k);
+        ValueRecord live{ValueType::kDeletion, ""};
+        ValueRecord replayed{ValueType::kDeletion, ""};
+        ASSERT_TRUE(mt.Get(key, live));
+        ASSERT_TRUE(mt_recovery.Get(key, replayed));
+        EXPECT_EQ(live.value, replayed.value) << key;
+    }
+}
+
+TEST_F(MemTableBaseTest, MemoryUsageTracksValueBytes) {
+    MemTable mt(basic_log);
+    // 空表只有跳表头节点占的那一个块
+    const size_t base = mt.ApproximateMemoryUsage();
+
+    const std::string big_value(64 * 1024, 'x');
+    for (int i = 0; i < 16; ++i) {
+        mt.Put("k_" + std::to_string(i), MakeValue(big_value));
+    }
+    // 16 个 64KB 的 value 至少占 1MB，且额外开销不会超过一个块的量级
+    const size_t used = mt.ApproximateMemoryUsage() - base;
+    EXPECT_GE(used, 16 * big_value.size());
+    EXPECT_LT(used, 16 * big_value.size() + 64 * 1024);
+}
+
+TEST_F(MemTableBaseTest, HashIndexServesPointLookups) {
+    MemTable mt(basic_log, 16, 1024);
+    for (int i = 0; i < 500; ++i) {
+        mt.Put("k_" + std::to_string(i), MakeValue("v_" + std::to_string(i)));
+    }
+    mt.Put("k_7", MakeValue("updated"));
+    mt.Remove("k_8");
+
+    ValueRecord rec{ValueType::kDeletion, ""};
+    EXPECT_TRUE(mt.Get("k_0", rec));
+    EXPECT_EQ(rec.value, "v_0");
+    EXPECT_TRUE(mt.Get("k_7", rec));
+    EXPECT_EQ(rec.value, "updated");
+    EXPECT_TRUE(mt.Get("k_8", rec));
+    EXPECT_EQ(rec.type, ValueType::kDeletion);
+    EXPECT_FALSE(mt.Get("missing", rec));
+
+    // 有序遍历不受索引影响
+    int count = 0;
+    for (auto it = mt.GetIterator(); it.Valid(); it.Next()) {
+        ++count;
+    }
+    EXPECT_EQ(count, 500);
+}
+
+TEST_F(MemTableBaseTest, HashIndexOverflowFallsBackToSkipList) {
+    // 只有 4 个槽位，大部分 key 登记不进索引，必须退回跳表查找
+    MemTable mt(basic_log, 16, 4);
+    for (int i = 0; i < 200; ++i) {
+        mt.Put("k_" + std::to_string(i), MakeValue("v_" + std::to_string(i)));
+    }
+
+    ValueRecord rec{ValueType::kDeletion, ""};
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(mt.Get("k_" + std::to_string(i), rec));
+        EXPECT_EQ(rec.value, "v_" + std::to_string(i));
+    }
+    EXPECT_FALSE(mt.Get("missing", rec));
+}
+
+TEST_F(MemTableBaseTest, VectorRepSortsAndDedupsOnRead) {
+    MemTable mt(basic_log, 16, 0, MemTableRepType::kVector);
+    const int num_writers = 4;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < num_writers; ++i) {
+        workers.emplace_back([&mt, i]() {
+            // 倒序写入，保证 vector 处于无序状态
+            for (int k = 999; k >= 0; --k) {
+                mt.Put("k_" + std::to_string(k), MakeValue("w" + std::to_string(i)));
+            }
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+    mt.Remove("k_5");
+
+    // 同一个 key 的多次覆盖在排序时合并，只留 WAL 中最靠后的一条
+    std::string prev;
+    int rows = 0;
+    for (auto it = mt.GetIterator(); it.Valid(); it.Next()) {
+        const std::string key(it.key());
+        if (rows > 0) {
+            EXPECT_LT(prev, key);
+        }
+        prev = key;
+        ++rows;
+    }
+    EXPECT_EQ(rows, 1000);
+    EXPECT_EQ(mt.Count(), 1000);
+
+    ValueRecord rec{ValueType::kValue, ""};
+    EXPECT_TRUE(mt.Get("k_5", rec));
+    EXPECT_EQ(rec.type, ValueType::kDeletion);
+    EXPECT_TRUE(mt.Get("k_999", rec));
+    EXPECT_EQ(rec.type, ValueType::kValue);
+    EXPECT_FALSE(mt.Get("k_1000", rec));
+
+    // 与 WAL 重放到跳表里的结果逐条一致
+    MemTable replayed(persistence_log);
+    WalHandler wal(basic_log);
+    wal.LoadLog([&replayed](ValueType type, const std::string& k, const std::string& v) {
+        replayed.ApplyWithoutWal(k, ValueRecord{type, v});
+    });
+    for (auto it = replayed.GetIterator(); it.Valid(); it.Next()) {
+        ValueRecord live{ValueType::kValue, ""};
+        ASSERT_TRUE(mt.Get(std::string(it.key()), live));
+        EXPECT_EQ(live.type, it.type());
+        EXPECT_EQ(live.value, it.value());
+    }
+}
+
+TEST_F(MemTableBaseTest, IteratorSeekOnBothReps) {
+    for (const auto type : {MemTableRepType::kSkipList, MemTableRepType::kVector}) {
+        MemTable mt(basic_log, 16, 0, type);
+        for (int k = 99; k >= 0; --k) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "k_%02d", k);
+            mt.Put(buf, MakeValue(buf));
+        }
+        mt.Remove("k_50");
+
+        auto it = mt.GetIterator();
+        it.Seek("k_50");
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), "k_50");
+        EXPECT_EQ(it.type(), ValueType::kDeletion);
+
+        it.Seek("k_505");  // 不存在，落在后继 k_51
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), "k_51");
+
+        it.Seek("z");
+        EXPECT_FALSE(it.Valid());
+
+        // Snapshot 只拷贝起点之后的部分
+        const auto rows = mt.Snapshot("k_90");
+        ASSERT_EQ(rows.size(), 10u);
+        EXPECT_EQ(rows.front().first, "k_90");
+        EXPECT_EQ(rows.back().first, "k_99");
+
+        std::filesystem::remove(basic_log);
+    }
+}
+
+// 8 个线程并发写 mt（WAL 为 basic_log），写完后重放 WAL，结果应与内存里逐条一致
+static void CheckConcurrentWritesMatchWal(MemTable& mt, const std::string& basic_log) {
+    const int num_writers = 8;
+    std::vector<std::thread> workers;
+    for (int i = 0; i < num_writers; ++i) {
+        workers.emplace_back([&mt, i]() {
+            // 所有线程争抢同一小批 key，大量写入会被合并进同一次 WAL 写
+            for (int k = 0; k < 2000; ++k) {
+                const std::string key = "k_" + std::to_string(k % 50);
+                if (k % 7 == i) {
+                    mt.Remove(key);
+                } else {
+                    mt.Put(key, MakeValue(std::to_string(i) + "_" + std::to_string(k)));
+                }
+            }
+        });
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    // WAL 中每条记录都完整可读，重放结果与内存里的最终状态逐条一致
+    MemTable replayed("");
+    int records = 0;
+    WalHandler wal(basic_log);
+    wal.LoadLog([&](ValueType type, const std::string& k, const std::string& v) {
+        replayed.ApplyWithoutWal(k, ValueRecord{type, v});
+        ++records;
+    });
+    EXPECT_EQ(records, num_writers * 2000);
+    EXPECT_EQ(replayed.Count(), mt.Count());
+    for (auto it = replayed.GetIterator(); it.Valid(); it.Next()) {
+        ValueRecord live{ValueType::kValue, ""};
+        ASSERT_TRUE(mt.Get(it.key(), live));
+        EXPECT_EQ(live.type, it.type());
+        EXPECT_EQ(live.value, it.value());
+    }
+}
+
+TEST_F(MemTableBaseTest, GroupCommitKeepsWalOrder) {
+    MemTable mt(basic_log);
+    CheckConcurrentWritesMatchWal(mt, basic_log);
+}
+
+// 流水线写：先插入内存、后台线程再写 WAL，返回前日志一定已经写完，顺序也不乱
+TEST_F(MemTableBaseTest, PipelinedWriteKeepsWalOrder) {
+    MemTable mt(basic_log, 16, 0, MemTableRepType::kSkipList, WalOpenOptions(), true);
+    CheckConcurrentWritesMatchWal(mt, basic_log);
+
+    // 单线程写：每次 Put 返回时记录都已经能从 WAL 里读出来
+    MemTable single(persistence_log, 16, 0, MemTableRepType::kSkipList, WalOpenOptions(),
+                    true);
+    for (int i = 0; i < 3; ++i) {
+        single.Put("p_" + std::to_string(i), MakeValue("v"));
+        int records = 0;
+        WalHandler wal(persistence_log);
+        wal.LoadLog([&](ValueType, const std::string&, const std::string&) { ++records; });
+        EXPECT_EQ(records, i + 1);
+    }
+}
+
+// WriteBatch 写成同一条 WAL 逻辑记录：日志尾部被截断时整批都不回放，不会只剩半批
+TEST_F(MemTableBaseTest, WriteBatchIsOneWalRecord) {
+    {
+        MemTable mt(basic_log);
+        mt.Put("before", MakeValue("v"));
+        WriteBatch batch;
+        for (int i = 0; i < 50; ++i) {
+            batch.Put("b_" + std::to_string(i), std::string(1024, 'x'));
+        }
+        batch.Delete("before");
+        mt.Write(batch);
+        EXPECT_EQ(mt.Count(), 51);
+        ValueRecord rec{ValueType::kValue, ""};
+        ASSERT_TRUE(mt.Get("before", rec));
+        EXPECT_EQ(rec.type, ValueType::kDeletion);
+    }
+
+    std::vector<std::string> keys;
+    auto replay = [&]() {
+        keys.clear();
+        WalHandler wal(basic_log);
+        wal.LoadLog([&](ValueType, const std::string& k, const std::string&) {
+            keys.push_back(k);
+        });
+    };
+    replay();
+    ASSERT_EQ(keys.size(), 52u);
+    EXPECT_EQ(keys.back(), "before");
+
+    std::filesystem::resize_file(basic_log, std::filesystem::file_size(basic_log) - 100);
+    replay();
+    ASSERT_EQ(keys.size(), 1u);
+    EXPECT_EQ(keys[0], "before");
+}
+
+// 同一个 key 的每次写入都留在版本链上：按序号读到当时的值，WAL 回放出相同的序号
+TEST_F(MemTableBaseTest, VersionChainServesSnapshots) {
+    for (const auto type : {MemTableRepType::kSkipList, MemTableRepType::kVector}) {
+        std::filesystem::remove(basic_log);
+        MemTable mt(basic_log, 16, 0, type);
+        mt.SetLastSequence(100);
+        mt.Put("k", MakeValue("v1"));
+        const SequenceNumber first = mt.VisibleSequence();
+        mt.Put("k", MakeValue("v2"));
+        mt.Remove("k");
+        EXPECT_EQ(mt.VisibleSequence(), first + 2);
+
+        ValueRecord rec{ValueType::kValue, ""};
+        EXPECT_FALSE(mt.Get("k", rec, first - 1));
+        ASSERT_TRUE(mt.Get("k", rec, first));
+        EXPECT_EQ(rec.value, "v1");
+        ASSERT_TRUE(mt.Get("k", rec, first + 1));
+        EXPECT_EQ(rec.value, "v2");
+        ASSERT_TRUE(mt.Get("k", rec));
+        EXPECT_EQ(rec.type, ValueType::kDeletion);
+        EXPECT_EQ(rec.sequence, first + 2);
+
+        std::vector<SequenceNumber> versions;
+        for (auto it = mt.NewVersionIterator(); it->Valid(); it->Next()) {
+            EXPECT_EQ(it->key(), "k");
+            versions.push_back(it->sequence());
+        }
+        EXPECT_EQ(versions, (std::vector<SequenceNumber>{first + 2, first + 1, first}));
+
+        // 乱序回放（比如按别的顺序拿到的记录）也按序号挂到链上对应的位置
+        MemTable replayed("");
+        WalHandler wal(basic_log);
+        std::vector<std::pair<SequenceNumber, ValueRecord>> records;
+        wal.LoadLogWithSequence([&](SequenceNumber sequence, ValueType t,
+                                    const std::string&, const std::string& v) {
+            records.emplace_back(sequence, ValueRecord{t, v});
+        });
+        ASSERT_EQ(records.size(), 3u);
+        for (const size_t i : {1, 2, 0}) {
+            replayed.ApplyWithoutWal("k", records[i].second, records[i].first);
+        }
+        ASSERT_TRUE(replayed.Get("k", rec, first + 1));
+        EXPECT_EQ(rec.value, "v2");
+        EXPECT_EQ(replayed.VisibleSequence(), first + 2);
+    }
+}
+
+// WAL 写失败：Put / Write 返回 false，组提交里的每个 follower 都拿到失败，
+// 失败的写入不公布，读者看不到；流水线模式下已经插进 Rep 的也一样
+TEST_F(MemTableBaseTest, FailedWalWriteIsNotAcknowledged) {
+    if (!std::filesystem::exists("/dev/full")) {
+        GTEST_SKIP() << "/dev/full not available";
+    }
+    for (const bool pipelined : {false, true}) {
+        MemTable mt("/dev/full", 16, 0, MemTableRepType::kSkipList, WalOpenOptions(),
+                    pipelined);
+        EXPECT_FALSE(mt.Put("k", MakeValue("v"), true));
+        EXPECT_TRUE(mt.WalFailed());
+
+        std::vector<std::thread> writers;
+        std::atomic<int> acked{0};
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&mt, &acked, t]() {
+                for (int i = 0; i < 100; ++i) {
+                    if (mt.Put("k_" + std::to_string(t) + "_" + std::to_string(i),
+                               MakeValue("v"))) {
+                        ++acked;
+                    }
+                }
+            });
+        }
+        for (auto& writer : writers) {
+            writer.join();
+        }
+        EXPECT_EQ(acked.load(), 0);
+
+        WriteBatch batch;
+        batch.Put("b", "v");
+        EXPECT_FALSE(mt.Write(batch));
+
+        EXPECT_EQ(mt.VisibleSequence(), 0u);
+        ValueRecord rec{ValueType::kValue, ""};
+        EXPECT_FALSE(mt.Get("k", rec, mt.VisibleSequence()));
+        EXPECT_FALSE(mt.Get("k_0_0", rec, mt.VisibleSequence()));
+    }
+}
@@ -0,0 +1,41 @@
+#include "Random.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+// Test Intent: 验证 NextHeight 的分布和原来逐层抛硬币一致（每层约减半），
+// 且永远落在 [1, max_height] 之内。
+TEST(RandomTest, HeightFollowsHalfGeometricDistribution) {
+  Random rng(12345);
+  constexpr int kMaxHeight = 12;
+  constexpr int kSamples = 1 << 20;
+  std::vector<int> hist(kMaxHeight + 1, 0);
+  for (int i = 0; i < kSamples; ++i) {
+    const int h = rng.NextHeight(kMaxHeight);
+    ASSERT_GE(h, 1);
+    ASSERT_LE(h, kMaxHeight);
+    ++hist[h];
+  }
+
+  // P(h = k) = 1 / 2^k，样本足够多时允许 5% 的相对误差
+  for (int k = 1; k <= 6; ++k) {
+    const double expected = static_cast<double>(kSamples) / (1 << k);
+    EXPECT_NEAR(hist[k], expected, expected * 0.05) << "height " << k;
+  }
+  // 封顶层吸收了所有更高的结果，概率是 1 / 2^(max - 1)
+  const double top = static_cast<double>(kSamples) / (1 << (kMaxHeight - 1));
+  EXPECT_NEAR(hist[kMaxHeight], top, top * 0.5);
+}
+
+TEST(RandomTest, MaxHeightOneAlwaysReturnsOne) {
+  Random rng(1);
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_EQ(rng.NextHeight(1), 1);
+  }
+}
+
+TEST(RandomTest, ZeroSeedStillProducesValues) {
+  Random rng(0);
+  EXPECT_NE(rng.Next(), 0u);
+}
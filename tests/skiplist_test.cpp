@@ -1,7 +1,13 @@
 #include <gtest/gtest.h>
 #include "SkipList.h"
+#include <algorithm>
 #include <climits>
+#include <cstdio>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 // 定义 Fixture 类
 class SkipListTest : public ::testing::Test {
@@ -80,4 +86,133 @@ TEST_F(SkipListTest, MassiveDataWithIterator) {
         it.Next();
     }
     EXPECT_FALSE(it.Valid());
-}
\ No newline at end of file
+}
+// 5. 多线程无锁插入：各线程插入交错的 key，结果必须有序且不丢不重
+TEST(SkipListConcurrentTest, ConcurrentInsertKeepsOrder) {
+    SkipList<int, int> list(16);
+    const int num_threads = 4;
+    const int per_thread = 5000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < num_threads; ++t) {
+        workers.emplace_back([&list, t]() {
+            for (int i = 0; i < per_thread; ++i) {
+                const int key = i * num_threads + t;
+                list.insert_element(key, key * 2);
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    EXPECT_EQ(list.size(), num_threads * per_thread);
+    auto it = list.begin();
+    for (int i = 0; i < num_threads * per_thread; ++i) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), i);
+        EXPECT_EQ(it.value(), i * 2);
+        it.Next();
+    }
+    EXPECT_FALSE(it.Valid());
+}
+
+// 6. 字符串 key 的前缀缓存：共享长前缀、短于 8 字节、内嵌 '\0' 的 key 都要保持字典序
+TEST(SkipListPrefixTest, StringKeysKeepLexicographicOrder) {
+    std::vector<std::string> keys = {
+        "tenant_0001/user/42", "tenant_0001/user/7", "tenant_0001/",
+        "tenant_0001", "tenant_0002/a", "a", "ab", std::string("a\0", 2),
+        std::string("a\0b", 3), "", "\xff\xff", "zzzzzzzzzz", "tenant_00"};
+    SkipList<std::string_view, int> list(16);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        list.insert_element(keys[i], static_cast<int>(i));
+    }
+
+    std::vector<std::string> sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    auto it = list.begin();
+    for (const auto& expected : sorted) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), expected);
+        it.Next();
+    }
+    EXPECT_FALSE(it.Valid());
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        int value = -1;
+        ASSERT_TRUE(list.search_element(keys[i], value)) << i;
+        EXPECT_EQ(value, static_cast<int>(i));
+    }
+    int value = -1;
+    EXPECT_FALSE(list.search_element("tenant_0001/user/8", value));
+    EXPECT_FALSE(list.search_element(std::string("a\0\0", 3), value));
+}
+
+// 7. value 以右值传入时直接 move 进节点，只能移动的类型也能存
+TEST(SkipListPrefixTest, RvalueValuesAreMovedIn) {
+    SkipList<std::string, std::unique_ptr<int>> list(8);
+    list.insert_element("k1", std::make_unique<int>(1));
+    list.insert_element("k2", std::make_unique<int>(2));
+    list.insert_element("k1", std::make_unique<int>(10));
+
+    auto it = list.begin();
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), "k1");
+    EXPECT_EQ(*it.value(), 10);
+    it.Next();
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(*it.value(), 2);
+}
+
+// 8. 插入手指：顺序追加、回头插入、再追加交替进行，结果仍然完整有序
+TEST(SkipListFingerTest, MixedSequentialAndBackwardInserts) {
+    SkipList<int, int> list(16);
+    for (int i = 0; i < 3000; i += 3) {
+        list.insert_element(i, i);  // 顺序追加，走手指快速路径
+    }
+    for (int i = 2999; i > 0; i -= 3) {
+        list.insert_element(i, i);  // 倒序插入，手指每次都失效
+    }
+    for (int i = 1; i < 3000; i += 3) {
+        list.insert_element(i, i);  // 从头开始的顺序插入
+    }
+    list.insert_element(1500, -1);  // 覆盖已有 key
+
+    EXPECT_EQ(list.size(), 3000);
+    auto it = list.begin();
+    for (int i = 0; i < 3000; ++i) {
+        ASSERT_TRUE(it.Valid());
+        EXPECT_EQ(it.key(), i);
+        EXPECT_EQ(it.value(), i == 1500 ? -1 : i);
+        it.Next();
+    }
+    EXPECT_FALSE(it.Valid());
+}
+
+// 9. Seek 沿塔跳到第一个 >= target 的节点，不存在的 key 落在后继上
+TEST(SkipListSeekTest, SeekFindsLowerBound) {
+    SkipList<std::string, int> list(16);
+    for (int i = 0; i < 1000; i += 2) {
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "k%04d", i);
+        list.insert_element(buf, i);
+    }
+
+    auto it = list.begin();
+    it.Seek("k0500");
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.key(), "k0500");
+
+    it.Seek("k0501");  // 不存在，落在 k0502
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.value(), 502);
+    it.Next();
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.value(), 504);
+
+    it.Seek("");  // 比所有 key 都小，回到表头
+    ASSERT_TRUE(it.Valid());
+    EXPECT_EQ(it.value(), 0);
+
+    EXPECT_FALSE(list.lower_bound("k0999").Valid());
+    EXPECT_EQ(list.lower_bound("a").value(), 0);
+}
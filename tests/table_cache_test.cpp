@@ -0,0 +1,88 @@
+#include "TableCache.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+#include "SSTableBuilder.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string kDir = "./table_cache_test_dir";
+
+// 写一个只有 key -> value 一条记录的 SST，序号为 sequence
+void WriteTable(const uint64_t file_number, const std::string& key,
+                const std::string& value, const SequenceNumber sequence) {
+  WritableFile file(kDir + "/" + std::to_string(file_number) + ".sst");
+  SSTableBuilder builder(&file);
+  builder.Add(key, value, ValueType::kValue, sequence);
+  builder.Finish();
+}
+
+class TableCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    fs::remove_all(kDir);
+    fs::create_directories(kDir);
+    for (uint64_t n = 1; n <= 3; ++n) {
+      WriteTable(n, "k" + std::to_string(n), "v" + std::to_string(n), n * 10);
+    }
+  }
+  void TearDown() override { fs::remove_all(kDir); }
+};
+
+}  // namespace
+
+// Test Intent: 元数据只读 Footer，不打开 reader；按需打开的 reader 超过
+// max_open_files 时淘汰最久没用的，被淘汰的 reader 对持有它的读者仍然可用。
+TEST_F(TableCacheTest, OpensOnDemandAndEvictsLeastRecentlyUsed) {
+  TableCache cache(kDir, 2, nullptr);
+
+  FileMetaData meta;
+  ASSERT_TRUE(cache.ReadMetaData(2, &meta));
+  EXPECT_EQ(meta.number, 2u);
+  EXPECT_EQ(meta.file_size, fs::file_size(cache.TablePath(2)));
+  EXPECT_EQ(meta.max_sequence, 20u);
+  EXPECT_EQ(cache.OpenFiles(), 0u);
+
+  const std::shared_ptr<SSTableReader> first = cache.Get(1);
+  ASSERT_NE(first, nullptr);
+  ASSERT_NE(cache.Get(2), nullptr);
+  EXPECT_EQ(cache.OpenFiles(), 2u);
+  // 再次命中拿到的是同一个 reader，并且 2 变成最新的
+  EXPECT_EQ(cache.Get(1), first);
+  ASSERT_NE(cache.Get(2), nullptr);
+
+  // 打开 3 时淘汰最久没用的 1，但手里的引用照样能读
+  ASSERT_NE(cache.Get(3), nullptr);
+  EXPECT_EQ(cache.OpenFiles(), 2u);
+  std::string value;
+  ASSERT_TRUE(first->Get("k1", &value));
+  EXPECT_EQ(value, "v1");
+  // 被淘汰的文件下次读时重新打开
+  EXPECT_NE(cache.Get(1), first);
+
+  cache.Evict(1);
+  EXPECT_EQ(cache.OpenFiles(), 1u);
+}
+
+// Test Intent: 文件不存在或不是 SST 时打开失败，不会占用缓存。
+TEST_F(TableCacheTest, MissingOrCorruptFileFails) {
+  TableCache cache(kDir, 4, nullptr);
+  FileMetaData meta;
+  EXPECT_FALSE(cache.ReadMetaData(42, &meta));
+  EXPECT_EQ(cache.Get(42), nullptr);
+
+  {
+    WritableFile file(cache.TablePath(5));
+    file.Append(std::string(100, 'x'));
+    file.Flush();
+  }
+  EXPECT_FALSE(cache.ReadMetaData(5, &meta));
+  EXPECT_EQ(cache.Get(5), nullptr);
+  EXPECT_EQ(cache.OpenFiles(), 0u);
+}
@@ -0,0 +1,283 @@
+#include "WalHandler.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+using Row = std::tuple<ValueType, std::string, std::string>;
+
+std::vector<Row> ReadAll(const std::string& path) {
+  std::vector<Row> rows;
+  WalHandler wal(path);
+  wal.LoadLog([&rows](ValueType type, const std::string& k,
+                      const std::string& v) { rows.emplace_back(type, k, v); });
+  return rows;
+}
+
+// 按旧格式（无文件头、CRC32）手工拼一条记录
+std::string LegacyRecord(const std::string& key, const std::string& value,
+                         ValueType type) {
+  std::string body;
+  const auto t = static_cast<uint8_t>(type);
+  const auto k_len = static_cast<uint32_t>(key.size());
+  const auto v_len = static_cast<uint32_t>(value.size());
+  body.append(reinterpret_cast<const char*>(&t), 1);
+  body.append(reinterpret_cast<const char*>(&k_len), 4);
+  body.append(key);
+  body.append(reinterpret_cast<const char*>(&v_len), 4);
+  body.append(value);
+
+  uint32_t crc = 0xFFFFFFFF;
+  for (const char c : body) {
+    crc ^= static_cast<unsigned char>(c);
+    for (int j = 0; j < 8; ++j) {
+      crc = (crc >> 1) ^ (crc & 1 ? 0xEDB88320 : 0);
+    }
+  }
+  crc ^= 0xFFFFFFFF;
+  return std::string(reinterpret_cast<const char*>(&crc), 4) + body;
+}
+}  // namespace
+
+class WalTest : public ::testing::Test {
+ protected:
+  const std::string wal_path = "test_wal_format.wal";
+
+  void SetUp() override { fs::remove(wal_path); }
+  void TearDown() override { fs::remove(wal_path); }
+};
+
+// 1. 新文件带文件头，使用带序号的分块格式
+TEST_F(WalTest, NewFileHasHeaderAndRoundTrips) {
+  {
+    WalHandler wal(wal_path);
+    wal.AddLog("k1", "v1", ValueType::kValue);
+    wal.AddLog("k2", "", ValueType::kDeletion);
+  }
+  std::ifstream in(wal_path, std::ios::binary);
+  char header[WalHandler::kHeaderSize];
+  ASSERT_TRUE(in.read(header, sizeof(header)));
+  EXPECT_EQ(std::memcmp(header, WalHandler::kMagic, WalHandler::kMagicSize), 0);
+  EXPECT_EQ(static_cast<uint8_t>(header[WalHandler::kMagicSize]),
+            WalHandler::kVersionSequenced);
+
+  const auto rows = ReadAll(wal_path);
+  ASSERT_EQ(rows.size(), 2u);
+  EXPECT_EQ(rows[0], Row(ValueType::kValue, "k1", "v1"));
+  EXPECT_EQ(rows[1], Row(ValueType::kDeletion, "k2", ""));
+}
+
+// 2. 只读打开（回放）不存在的文件不会写出文件头
+TEST_F(WalTest, ReadOnlyOpenLeavesFileEmpty) {
+  EXPECT_TRUE(ReadAll(wal_path).empty());
+  EXPECT_EQ(fs::file_size(wal_path), 0u);
+}
+
+// 3. 旧格式 WAL 仍能回放；继续往里追加时沿用旧格式，不插文件头
+TEST_F(WalTest, LegacyFileStillReplays) {
+  {
+    std::ofstream out(wal_path, std::ios::binary);
+    out << LegacyRecord("old1", "a", ValueType::kValue)
+        << LegacyRecord("old2", "", ValueType::kDeletion);
+  }
+  {
+    WalHandler wal(wal_path);
+    wal.AddLog("new1", "b", ValueType::kValue);
+  }
+  const auto rows = ReadAll(wal_path);
+  ASSERT_EQ(rows.size(), 3u);
+  EXPECT_EQ(rows[0], Row(ValueType::kValue, "old1", "a"));
+  EXPECT_EQ(rows[1], Row(ValueType::kDeletion, "old2", ""));
+  EXPECT_EQ(rows[2], Row(ValueType::kValue, "new1", "b"));
+}
+
+// 4. 校验和不对的记录及其之后的内容都不回放
+TEST_F(WalTest, CorruptedRecordStopsReplay) {
+  {
+    WalHandler wal(wal_path);
+    wal.AddLog("good", "1", ValueType::kValue);
+    wal.AddLog("bad", "2", ValueType::kValue);
+  }
+  {
+    // 改掉最后一个字节（第二条记录的 value）
+    std::fstream f(wal_path, std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(-1, std::ios::end);
+    f.put('X');
+  }
+  const auto rows = ReadAll(wal_path);
+  ASSERT_EQ(rows.size(), 1u);
+  EXPECT_EQ(rows[0], Row(ValueType::kValue, "good", "1"));
+}
+
+// 5. 大 value 切成 FIRST/MIDDLE/LAST 跨越多个块，和小记录交替写入
+TEST_F(WalTest, LargeRecordsSpanBlocks) {
+  const std::string big(3 * WalHandler::kBlockSize + 123, 'b');
+  std::vector<Row> expected;
+  {
+    WalHandler wal(wal_path);
+    for (int i = 0; i < 20; ++i) {
+      const std::string key = "k" + std::to_string(i);
+      const std::string value = i % 3 == 0 ? big : std::string(i * 100, 'v');
+      wal.AddLog(key, value, ValueType::kValue);
+      expected.emplace_back(ValueType::kValue, key, value);
+    }
+  }
+  EXPECT_EQ(ReadAll(wal_path), expected);
+}
+
+// 6. 块尾剩余不足一个物理记录头时补零，回放跳过补零继续读下一块
+TEST_F(WalTest, BlockTrailerIsPadded) {
+  // 文件头 8 + 物理头 7 + 序号 8 + Payload(1 + 4 + 1 + 4 + v) = 块大小 - 3
+  const size_t value_len =
+      WalHandler::kBlockSize - 3 - WalHandler::kHeaderSize -
+      WalHandler::kFragmentHeaderSize - WalHandler::kSequenceHeaderSize - 10;
+  {
+    WalHandler wal(wal_path);
+    wal.AddLog("a", std::string(value_len, 'x'), ValueType::kValue);
+    wal.AddLog("b", "after padding", ValueType::kValue);
+  }
+  EXPECT_EQ(fs::file_size(wal_path),
+            WalHandler::kBlockSize + WalHandler::kFragmentHeaderSize +
+                WalHandler::kSequenceHeaderSize + 23);
+  const auto rows = ReadAll(wal_path);
+  ASSERT_EQ(rows.size(), 2u);
+  EXPECT_EQ(rows[1], Row(ValueType::kValue, "b", "after padding"));
+}
+
+// 7. 崩溃时最后一次写入只写了一半：之前完整的记录照常回放
+TEST_F(WalTest, TruncatedTailIsIgnored) {
+  {
+    WalHandler wal(wal_path);
+    wal.AddLog("k1", "v1", ValueType::kValue);
+    wal.AddLog("k2", std::string(2 * WalHandler::kBlockSize, 'z'),
+               ValueType::kValue);
+  }
+  fs::resize_file(wal_path, fs::file_size(wal_path) - 100);
+  const auto rows = ReadAll(wal_path);
+  ASSERT_EQ(rows.size(), 1u);
+  EXPECT_EQ(rows[0], Row(ValueType::kValue, "k1", "v1"));
+}
+
+// 8. 重新打开已有的分块文件继续追加，块内偏移接得上
+TEST_F(WalTest, ReopenContinuesBlockLayout) {
+  std::vector<Row> expected;
+  for (int round = 0; round < 3; ++round) {
+    WalHandler wal(wal_path);
+    for (int i = 0; i < 50; ++i) {
+      const std::string key = std::to_string(round) + "_" + std::to_string(i);
+      const std::string value(700 + i, 'r');
+      wal.AddLog(key, value, ValueType::kValue);
+      expected.emplace_back(ValueType::kValue, key, value);
+    }
+  }
+  EXPECT_EQ(ReadAll(wal_path), expected);
+}
+
+// 9. 复用旧文件：从头覆盖写，上一轮留下的更长的残尾不会被回放
+TEST_F(WalTest, RecycledFileIgnoresStaleTail) {
+  const std::string old_path = "7.wal";
+  const std::string new_path = "9.wal";
+  {
+    WalOpenOptions options;
+    options.log_number = 7;
+    WalHandler wal(old_path, options);
+    for (int i = 0; i < 200; ++i) {
+      wal.AddLog("old_" + std::to_string(i), std::string(500, 'o'),
+                 ValueType::kValue);
+    }
+  }
+  ASSERT_EQ(ReadAll(old_path).size(), 200u);
+  fs::rename(old_path, new_path);
+  const auto old_size = fs::file_size(new_path);
+
+  // 改名后还没写入：文件头编号和文件名对不上，整个文件都不回放
+  EXPECT_TRUE(ReadAll(new_path).empty());
+
+  {
+    WalOpenOptions options;
+    options.log_number = 9;
+    options.recycle = true;
+    WalHandler wal(new_path, options);
+    wal.AddLog("new_1", "a", ValueType::kValue);
+    wal.AddLog("new_2", std::string(WalHandler::kBlockSize, 'n'),
+               ValueType::kValue);
+  }
+  // 原地覆盖，文件长度不变
+  EXPECT_EQ(fs::file_size(new_path), old_size);
+  const auto rows = ReadAll(new_path);
+  ASSERT_EQ(rows.size(), 2u);
+  EXPECT_EQ(rows[0], Row(ValueType::kValue, "new_1", "a"));
+  EXPECT_EQ(std::get<1>(rows[1]), "new_2");
+  fs::remove(new_path);
+}
+
+// 10. 预分配只占磁盘块，不改变文件长度，回放不受影响
+TEST_F(WalTest, PreallocateKeepsFileSize) {
+  {
+    WalOpenOptions options;
+    options.preallocate_bytes = 1 << 20;
+    WalHandler wal(wal_path, options);
+    wal.AddLog("k", "v", ValueType::kValue);
+  }
+  EXPECT_LT(fs::file_size(wal_path), WalHandler::kBlockSize);
+  const auto rows = ReadAll(wal_path);
+  ASSERT_EQ(rows.size(), 1u);
+  EXPECT_EQ(rows[0], Row(ValueType::kValue, "k", "v"));
+}
+
+// 11. 每条逻辑记录带起始序号，批内依次加一；AddLog 不指定序号，回放出 0
+TEST_F(WalTest, SequencesRoundTrip) {
+  {
+    WalHandler wal(wal_path);
+    std::string batch;
+    wal.BeginBatch(&batch, 41);
+    wal.EncodeRecord(&batch, "a", "1", ValueType::kValue);
+    wal.EncodeRecord(&batch, "b", "", ValueType::kDeletion);
+    wal.AddRecords(batch);
+    wal.AddLog("c", "3", ValueType::kValue);
+  }
+  std::vector<std::pair<SequenceNumber, std::string>> rows;
+  WalHandler wal(wal_path);
+  wal.LoadLogWithSequence([&rows](const SequenceNumber sequence, ValueType,
+                                  const std::string& k, const std::string&) {
+    rows.emplace_back(sequence, k);
+  });
+  ASSERT_EQ(rows.size(), 3u);
+  EXPECT_EQ(rows[0], std::make_pair(SequenceNumber{41}, std::string("a")));
+  EXPECT_EQ(rows[1], std::make_pair(SequenceNumber{42}, std::string("b")));
+  EXPECT_EQ(rows[2], std::make_pair(SequenceNumber{0}, std::string("c")));
+}
+
+// 12. 写失败之后 WAL 不再接受任何写入：块内偏移已经和文件对不上，
+// 再写进去的记录回放时也读不到，不能让调用方以为写成功了
+TEST_F(WalTest, FailedWriteRejectsLaterAppends) {
+  if (!fs::exists("/dev/full")) {
+    GTEST_SKIP() << "/dev/full not available";
+  }
+  WalHandler wal("/dev/full");
+  std::string batch;
+  wal.BeginBatch(&batch, 1);
+  wal.EncodeRecord(&batch, "k", "v", ValueType::kValue);
+  EXPECT_FALSE(wal.Failed());
+  EXPECT_FALSE(wal.AddRecords(batch));
+  EXPECT_TRUE(wal.Failed());
+  EXPECT_FALSE(wal.AddLog("k2", "v2", ValueType::kValue));
+  EXPECT_FALSE(wal.Sync());
+  EXPECT_EQ(wal.SyncCount(), 0u);
+
+  // 正常的 WAL 写入并同步成功
+  WalHandler good(wal_path);
+  EXPECT_TRUE(good.AddRecords(batch, true));
+  EXPECT_TRUE(good.Sync());
+  EXPECT_EQ(good.SyncCount(), 1u);
+  EXPECT_FALSE(good.Failed());
+}
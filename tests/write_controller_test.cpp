@@ -0,0 +1,47 @@
+#include "WriteController.h"
+
+#include <gtest/gtest.h>
+
+// Test Intent: 验证令牌桶只在 kDelayed 下生效、速率随积压压力单调下降且有下限，
+// 并发写入会依次排队（后来的写入等得更久）。
+TEST(WriteControllerTest, NoDelayUnlessDelayed) {
+  WriteController controller(1024 * 1024);
+  EXPECT_EQ(controller.condition(), WriteStallCondition::kNormal);
+  EXPECT_EQ(controller.GetDelay(1 << 20), 0u);
+  EXPECT_EQ(controller.delayed_write_rate(), 0u);
+
+  controller.SetCondition(WriteStallCondition::kStopped, 1.0);
+  EXPECT_EQ(controller.GetDelay(1 << 20), 0u);
+  EXPECT_EQ(controller.delayed_write_rate(), 0u);
+}
+
+TEST(WriteControllerTest, RateDropsWithPressure) {
+  const uint64_t max_rate = 16 * 1024 * 1024;
+  WriteController controller(max_rate);
+  controller.SetCondition(WriteStallCondition::kDelayed, 0.0);
+  EXPECT_EQ(controller.delayed_write_rate(), max_rate);
+
+  controller.SetCondition(WriteStallCondition::kDelayed, 0.5);
+  EXPECT_EQ(controller.delayed_write_rate(), max_rate / 2);
+
+  // 积压到顶也不会降成 0
+  controller.SetCondition(WriteStallCondition::kDelayed, 1.0);
+  EXPECT_EQ(controller.delayed_write_rate(), max_rate / 16);
+
+  controller.SetCondition(WriteStallCondition::kNormal, 0.0);
+  EXPECT_EQ(controller.delayed_write_rate(), 0u);
+}
+
+TEST(WriteControllerTest, DelayMatchesRateAndQueuesWriters) {
+  // 1MB/s：每 1KB 大约要等 1ms
+  WriteController controller(1024 * 1024);
+  controller.SetCondition(WriteStallCondition::kDelayed, 0.0);
+
+  const uint64_t first = controller.GetDelay(100 * 1024);
+  EXPECT_GT(first, 90000u);
+  EXPECT_LT(first, 110000u);
+
+  // 令牌已经被预支，紧接着的写入排在前一个后面
+  const uint64_t second = controller.GetDelay(100 * 1024);
+  EXPECT_GT(second, first + 90000u);
+}